@@ -0,0 +1,97 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "Arena.h"
+#include <algorithm>
+#include <cstdint>
+
+#if defined(_WIN32)
+    #define JSONPROC_NO_MMAP 1
+#else
+    #include <sys/mman.h>
+#endif
+
+namespace JSONProc {
+
+    Arena::Arena(bool useHugePages)
+        : nextChunkSize(useHugePages ? kHugePageSize : kFirstChunkSize), useHugePages(useHugePages) {}
+
+    Arena::~Arena() {
+        release();
+    }
+
+    void Arena::keep(std::shared_ptr<Arena> anArena) {
+        if (anArena.get() != this && std::find(kept.begin(), kept.end(), anArena) == kept.end())
+            kept.push_back(std::move(anArena));
+    }
+
+    void Arena::release() {
+        for (const auto &theChunk : chunks) {
+#ifndef JSONPROC_NO_MMAP
+            if (theChunk.isMapped) {
+                ::munmap(theChunk.data, theChunk.size);
+                continue;
+            }
+#endif
+            ::operator delete(theChunk.data);
+        }
+        chunks.clear();
+        kept.clear();
+        cursor = limit = nullptr;
+        reserved = used = 0;
+    }
+
+    size_t Arena::getReserved() const {
+        size_t theTotal = reserved;
+        for (const auto &theArena : kept)
+            theTotal += theArena->getReserved();
+        return theTotal;
+    }
+
+    size_t Arena::getUsed() const {
+        size_t theTotal = used;
+        for (const auto &theArena : kept)
+            theTotal += theArena->getUsed();
+        return theTotal;
+    }
+
+    void* Arena::do_allocate(size_t aSize, size_t anAlignment) {
+        auto theStart = (reinterpret_cast<std::uintptr_t>(cursor) + anAlignment - 1) & ~(anAlignment - 1);
+        if (!cursor || theStart + aSize > reinterpret_cast<std::uintptr_t>(limit)) {
+            addChunk(aSize + anAlignment);
+            theStart = (reinterpret_cast<std::uintptr_t>(cursor) + anAlignment - 1) & ~(anAlignment - 1);
+        }
+
+        cursor = reinterpret_cast<char*>(theStart + aSize);
+        used += aSize;
+        return reinterpret_cast<void*>(theStart);
+    }
+
+    void Arena::addChunk(size_t aMinimumSize) {
+        Chunk theChunk{nullptr, std::max(nextChunkSize, aMinimumSize), false};
+        nextChunkSize = std::min(nextChunkSize * 2, kMaxChunkSize);
+
+#ifndef JSONPROC_NO_MMAP
+        if (useHugePages) {
+            theChunk.size = (theChunk.size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+            void *theMapping = ::mmap(nullptr, theChunk.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (theMapping != MAP_FAILED) {
+#ifdef MADV_HUGEPAGE
+                ::madvise(theMapping, theChunk.size, MADV_HUGEPAGE);
+#endif
+                theChunk.data = static_cast<char*>(theMapping);
+                theChunk.isMapped = true;
+            }
+        }
+#endif
+        if (!theChunk.data)
+            theChunk.data = static_cast<char*>(::operator new(theChunk.size));
+
+        chunks.push_back(theChunk);
+        reserved += theChunk.size;
+        cursor = theChunk.data;
+        limit = theChunk.data + theChunk.size;
+    }
+
+}
@@ -0,0 +1,71 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace JSONProc {
+
+    // Monotonic memory for one Model's nodes, strings and containers. Allocation bumps a pointer
+    // through chunks that double in size; nothing is freed until the whole arena goes, which
+    // takes one free per chunk and no destructors. Not thread safe: give each thread its own.
+    class Arena final : public std::pmr::memory_resource {
+    public:
+        static constexpr size_t kFirstChunkSize = 4 * 1024;
+        static constexpr size_t kMaxChunkSize = 16 * 1024 * 1024;
+        static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+
+        // With useHugePages, chunks are whole 2 MB pages where the system offers them
+        explicit Arena(bool useHugePages = false);
+        ~Arena() override;
+
+        Arena(const Arena&) = delete;
+        Arena &operator=(const Arena&) = delete;
+
+        // Objects built here are never destroyed, so they must only own arena memory
+        template <typename T, typename... Args>
+        T* create(Args&&... anArgs) {
+            return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(anArgs)...);
+        }
+
+        // Keeps anArena alive as long as this one, for nodes linked in from another Model
+        void keep(std::shared_ptr<Arena> anArena);
+
+        // Frees every chunk; whatever was built here must not be used afterwards
+        void release();
+
+        // Bytes held in chunks and bytes handed out, including kept arenas
+        size_t getReserved() const;
+        size_t getUsed() const;
+
+    protected:
+        void* do_allocate(size_t aSize, size_t anAlignment) override;
+        void do_deallocate(void*, size_t, size_t) override {} // freed with the arena
+        bool do_is_equal(const std::pmr::memory_resource &anOther) const noexcept override { return this == &anOther; }
+
+        void addChunk(size_t aMinimumSize);
+
+        struct Chunk {
+            char *data;
+            size_t size;
+            bool isMapped; // came from mmap rather than operator new
+        };
+
+        std::vector<Chunk> chunks;
+        char *cursor = nullptr;
+        char *limit = nullptr;
+        size_t nextChunkSize;
+        size_t reserved = 0;
+        size_t used = 0;
+        bool useHugePages;
+        std::vector<std::shared_ptr<Arena>> kept;
+    };
+
+}
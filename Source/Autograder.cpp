@@ -5,12 +5,19 @@
 #include "Autograder.h"
 
 #include "JSONParser.h"
+#include "JSONLines.h"
+#include "ParallelParser.h"
+#include "StreamingQuery.h"
+#include "StructuralIndex.h"
+#include "NumberKernels.h"
 #include "Debug.h"
 #include "Formatting.h"
 #include <iostream>
 #include <algorithm>
 #include <sstream>
+#include <cstring>
 #include <iomanip>
+#include <thread>
 
 #define assertWithMessage(expression, message) \
     if (!(expression)) { \
@@ -53,21 +60,1137 @@ namespace JSONProc {
                                                  .get("'nope'");
             assertWithMessage(theResult == std::nullopt, "Expected std::nullopt, got: '" + theResult.value() + "'");
         }
+        { // queries share the model's nodes instead of copying them
+            const size_t theUsed = theModel.getArena().getUsed();
+            for (int i = 0; i < 1000; ++i)
+                theModel.createQuery().select("'students'.1").get("'name'");
+            assertWithMessage(theModel.getArena().getUsed() == theUsed, "Queries copied the model");
+        }
+        { // a compiled path decodes its steps once and walks any document
+            const QueryPath thePath("'students'.1"), theName("'name'");
+            const auto &theSteps = thePath.getSteps();
+            assertWithMessage(theSteps.size() == 2 && "students" == theSteps[0].key && !theSteps[0].isNumber &&
+                1 == theSteps[1].index && theSteps[1].isNumber, "Wrong path steps");
+            const auto theResult = theModel.createQuery().select(thePath).get(theName);
+            assertWithMessage(theResult && theResult == theModel.createQuery().select("'students'.1").get("'name'"),
+                "Compiled and string paths differ");
+
+            Model theOther;
+            BufferSource theSource(R"({"students": [{}, {"name": "Ada"}]})");
+            JSONParser(theSource).parse(&theOther);
+            assertWithMessage(theOther.createQuery().select(thePath).get(theName).value_or("") == "\"Ada\"",
+                "Compiled path failed on a second document");
+            assertWithMessage(!theOther.createQuery().select(QueryPath("'students'.-1")).get(theName),
+                "Negative index selected something");
+        }
+        { // every index comparison, decided once per filter
+            Model theList;
+            BufferSource theSource(R"({"list": [10, 11, 12, 13, 14, 15, 16, 17, 18, 19], "keys": {"ab": 1, "b": 2, "abc": 3}})");
+            JSONParser(theSource).parse(&theList);
+            const std::vector<std::pair<std::string, size_t>> theFilters{
+                {"index == 4", 1}, {"index != 4", 9}, {"index < 4", 4}, {"index <= 4", 5},
+                {"index > 4", 5}, {"index >= 4", 6}, {"index 4", 0}, {"index > 2 and index < 6", 3},
+                {"index < 2 or index > 7", 4}, {"index == 1 or index == 1", 1}, {"index > 5 and index < 3", 0},
+                {"index != 3 and index != 4 or index == 4", 9}, {"index < 20", 10},
+                {"index <= 9223372036854775807", 10}, {"index > 9223372036854775807", 0},
+                {"index != 9223372036854775807", 10}, {"index == 9223372036854775807", 0}};
+            for (const auto& [theFilter, theCount] : theFilters) {
+                const size_t theResult = theList.createQuery().select("'list'").filter(theFilter).count();
+                assertWithMessage(theResult == theCount, theFilter + ": expected " + std::to_string(theCount) +
+                    ", got " + std::to_string(theResult));
+            }
+            assertWithMessage(theList.createQuery().select("'list'").filter("index >= 8").sum() == 37, "Wrong filtered sum");
+            assertWithMessage(theList.createQuery().select("'keys'").filter("key contains 'ab'").sum() == 4, "Wrong key filter");
+
+            // a condition that doesn't parse admits nothing, rather than leaving the selection unfiltered
+            for (const std::string theBroken : {"shout loudly", "value >", "key contains", "(index > 1"}) {
+                assertWithMessage(0 == theList.createQuery().select("'list'").filter(theBroken).count() &&
+                                  0 == theList.createQuery().select("'keys'").filter(theBroken).count(),
+                    "The unparseable filter " + theBroken + " admitted something");
+                assertWithMessage(theList.createQuery().select("'list'").filter(theBroken).get("*") == ModelNode(ModelNode::Type::list).toString(),
+                    "The unparseable filter " + theBroken + " got something");
+            }
+        }
+        { // index filters as ranges admit exactly what the element-by-element test admits
+            const std::vector<filterPolicy> thePolicies{
+                filterPolicy("index > 2 and index <= 7"), filterPolicy("index != 0 or (index < 3 and index != 1)"),
+                filterPolicy("index == 11 or index >= 9"), filterPolicy("not (index > 3 and index < 9)"),
+                filterPolicy("index 1"), filterPolicy()};
+            const ModelNode theItem(ModelNode::Type::null);
+            for (const auto& thePolicy : thePolicies) {
+                for (size_t theSize = 0; theSize <= 12; ++theSize) {
+                    const IndexRanges theRanges = thePolicy.getIndexRanges(theSize);
+                    size_t theCount = 0;
+                    for (size_t i = 0; i < theSize; ++i) {
+                        assertWithMessage(theRanges.contains(i) == thePolicy.isAdmittable(i, theItem), "Ranges and tests disagree");
+                        theCount += thePolicy.isAdmittable(i, theItem);
+                    }
+                    assertWithMessage(theRanges.count() == theCount && !theRanges.contains(theSize), "Wrong range count");
+                }
+            }
+
+            std::string theNumbers = "[0";
+            for (int i = 1; i < 1000; ++i)
+                theNumbers += ", " + std::to_string(i);
+            theNumbers += "]";
+            Model thePages;
+            BufferSource theSource(theNumbers);
+            JSONParser(theSource).parse(&thePages);
+            const auto thePage = thePages.createQuery().select("").filter("index >= 500 and index < 503").get("*");
+            assertWithMessage(thePage.value_or("") == "[500, 501, 502]", "Wrong page: " + thePage.value_or(""));
+        }
+        { // conditions on values and members, joined with and, or and not
+            Model theClass;
+            BufferSource theSource(R"({"students": [{"name": "Ada", "age": 19, "grade": 91.5}, {"name": "Bo", "age": 17, "grade": null},
+                {"name": "Cy", "age": 22, "grade": 78, "late": true}, {"name": "Di", "age": 18}, "n/a", 7],
+                "scores": {"math": 90, "art": 75.5, "id": "x7", "music": false}})");
+            JSONParser(theSource).parse(&theClass);
+            const std::vector<std::pair<std::string, size_t>> theFilters{
+                {"'age' >= 18", 3}, {"'grade' == null", 1}, {"not ('grade' == null)", 5},
+                {"'grade' > 80 or 'late' == true", 2}, {"value == 'n/a' or value > 5", 2}, {"'name' contains 'y'", 1},
+                {"index < 3 and 'age' < 20", 2}, {"value != 7", 5}, {"'age' >=", 0}, {"value == maybe", 0},
+                {"key contains 'a'", 0}, {"'age' >= 18 and not ('grade' == null)", 3}};
+            for (const auto& [theFilter, theCount] : theFilters) {
+                const size_t theResult = theClass.createQuery().select("'students'").filter(theFilter).count();
+                assertWithMessage(theResult == theCount, theFilter + ": expected " + std::to_string(theCount) +
+                    ", got " + std::to_string(theResult));
+            }
+            assertWithMessage(theClass.createQuery().select("'students'").filter("value > 5").sum() == 7, "Wrong value sum");
+            assertWithMessage(theClass.createQuery().select("'scores'").filter("value >= 80 or key contains 'i'").count() == 3,
+                "Wrong member filter");
+            assertWithMessage(theClass.createQuery().select("'scores'").filter("value < 80").sum() == 75.5, "Wrong member sum");
+            const auto theStudents = CommandProcessor(theClass).process("select('students').filter('age' >= 18 and not ('grade' == null)).count()");
+            assertWithMessage(theStudents.value_or("") == "3", "Wrong grouped command: " + theStudents.value_or(""));
+        }
+        { // min, max and avg reduce the admitted numbers; sums are compensated on every kernel
+            Model theList;
+            BufferSource theSource(R"({"list": [10, 11, 12, 13, 14, 15, 16, 17, 18, 19], "keys": {"ab": 1, "b": 2.5, "abc": 3},
+                "words": ["a", "b"], "empty": []})");
+            JSONParser(theSource).parse(&theList);
+            assertWithMessage(theList.createQuery().select("'list'").min() == 10.0 && theList.createQuery().select("'list'").max() == 19.0 &&
+                              theList.createQuery().select("'list'").avg() == 14.5, "Wrong list min, max or avg");
+            assertWithMessage(theList.createQuery().select("'list'").filter("index >= 8").min() == 18.0 &&
+                              theList.createQuery().select("'keys'").filter("key contains 'b'").max() == 3.0 &&
+                              theList.createQuery().select("'list'.3").max() == 13.0, "Wrong filtered min or max");
+            assertWithMessage(!theList.createQuery().select("'words'").min() && !theList.createQuery().select("'empty'").avg(),
+                "Reduced a container without numbers");
+            const auto theAverage = CommandProcessor(theList).process("select('list').filter(index < 3).avg()");
+            assertWithMessage(theAverage.value_or("") == "11", "Wrong avg command: " + theAverage.value_or(""));
+
+            std::vector<double> theValues{1e100, 1.0, -1e100};
+            assertWithMessage(NumberKernels::sum(theValues.data(), theValues.size()) == 1.0, "Sum lost a cancelled value");
+            theValues.assign(1000003, 0.1);
+            for (size_t i = 0; i < theValues.size(); i += 7)
+                theValues[i] = -static_cast<double>(i % 1000) / 3;
+            double theExpected = 0.0;
+            for (const auto theKernel : {NumberKernels::Kernel::scalar, NumberKernels::Kernel::avx2}) {
+                if (!NumberKernels::isSupported(theKernel))
+                    continue;
+                const double theSum = NumberKernels::sum(theValues.data(), theValues.size(), theKernel);
+                assertWithMessage(NumberKernels::Kernel::scalar == theKernel || theSum == theExpected, "Kernels disagree on a sum");
+                theExpected = theSum;
+                assertWithMessage(NumberKernels::getMinimum(theValues.data(), theValues.size(), theKernel) == -999.0 / 3 &&
+                                  NumberKernels::getMaximum(theValues.data(), theValues.size(), theKernel) == 0.1 &&
+                                  NumberKernels::getMinimum(theValues.data() + 1, 2, theKernel) == 0.1, "Wrong kernel min or max");
+            }
+            theValues.assign(1000000, 0.1);
+            assertWithMessage(std::fabs(NumberKernels::sum(theValues.data(), theValues.size()) - 100000.0) < 1e-8, "Sum drifted");
+        }
+        { // big reductions run in blocks, on threads when eager, and agree with the one-thread lazy run
+            const size_t kReadings = 2 * ModelQuery::kParallelReduction + 123;
+            std::string theReadings = "[";
+            for (size_t i = 0; i < kReadings; ++i)
+                theReadings += (i % 11 ? std::to_string(i % 1000) + "." + std::to_string(i % 7) : "\"n/a\"") + ",";
+            theReadings.back() = ']';
+
+            std::vector<std::string> theResults;
+            for (const ModelMode theMode : {ModelMode::eager, ModelMode::lazy}) {
+                Model theTable(theMode);
+                BufferSource theSource(theReadings);
+                JSONParser(theSource).parse(&theTable);
+                std::ostringstream theResult;
+                theResult << std::setprecision(17) << theTable.createQuery().select("").sum() << " "
+                          << *theTable.createQuery().select("").avg() << " " << *theTable.createQuery().select("").min() << " "
+                          << *theTable.createQuery().select("").max() << " "
+                          << theTable.createQuery().select("").filter("value >= 500").count() << " "
+                          << theTable.createQuery().select("").filter("index > 5 and value < 10").sum();
+                theResults.push_back(theResult.str());
+            }
+            assertWithMessage(theResults[0] == theResults[1], "Reductions depend on threads: " + theResults[0] + " vs " + theResults[1]);
+        }
+        { // * and .. select sets, the same way in eager and lazy Models
+            const QueryPath thePath("'a'..*.'b'");
+            assertWithMessage(thePath.selectsSet() && thePath.getSteps().size() == 4 &&
+                              QueryPath::Kind::descendants == thePath.getSteps()[1].kind &&
+                              QueryPath::Kind::wildcard == thePath.getSteps()[2].kind &&
+                              !QueryPath("'a'.'*'").selectsSet(), "Wrong set path steps");
+
+            const std::string theText = R"({"students": [{"name": "Ada", "grade": 90, "tags": {"grade": 5}},
+                {"name": "Bo", "grade": 80}, {"name": "Cy"}], "grade": 1})";
+            for (const ModelMode theMode : {ModelMode::eager, ModelMode::lazy}) {
+                Model theSchool(theMode);
+                BufferSource theSource(theText);
+                JSONParser(theSource).parse(&theSchool);
+                assertWithMessage(theSchool.createQuery().select("'students'.*.'grade'").sum() == 170, "Wrong wildcard sum");
+                assertWithMessage(theSchool.createQuery().select("..'grade'").count() == 4, "Wrong descendant count");
+                assertWithMessage(theSchool.createQuery().select("'students'.*").filter("'grade' >= 85").count() == 1,
+                    "Wrong filtered set");
+                assertWithMessage(theSchool.createQuery().select("'students'.5.*").count() == 0, "Missing step selected nodes");
+                const auto theGrades = theSchool.createQuery().select("'students'..'grade'").get("*");
+                assertWithMessage(theGrades.value_or("") == "[90, 5, 80]", "Wrong descendant order: " + theGrades.value_or(""));
+
+                ModelQuery theQuery = theSchool.createQuery();
+                theQuery.select("'students'.*");
+                const auto theName = theQuery.get("'name'");
+                assertWithMessage(!theName, "A set has no members");
+                const auto theNames = theQuery.select("'students'.*.'name'").get("*");
+                assertWithMessage(theNames.value_or("") == R"(["Ada", "Bo", "Cy"])", "Wrong reselect: " + theNames.value_or(""));
+            }
+
+            // wide enough to split across threads when eager
+            const size_t kRows = 3 * ModelQuery::kParallelFanOut;
+            std::string theRows = "{\"rows\": [";
+            for (size_t i = 0; i < kRows; ++i)
+                theRows += "{\"v\": " + std::to_string(i) + ", \"w\": [" + std::to_string(i % 7) + "]},";
+            theRows.back() = ']';
+            theRows += "}";
+            std::optional<std::string> theFirst;
+            for (const ModelMode theMode : {ModelMode::eager, ModelMode::lazy}) {
+                Model theTable(theMode);
+                BufferSource theSource(theRows);
+                JSONParser(theSource).parse(&theTable);
+                assertWithMessage(theTable.createQuery().select("'rows'.*.'v'").sum() == kRows * (kRows - 1) / 2.0, "Wrong wide sum");
+                assertWithMessage(theTable.createQuery().select("..").count() == 2 + 4 * kRows, "Wrong wide descent");
+                const auto theValues = theTable.createQuery().select("..'w'.*").get("*");
+                assertWithMessage(theValues && (!theFirst || theValues == theFirst) && 0 == theValues->rfind("[0, 1, 2, 3", 0),
+                    "Wide descent lost document order");
+                theFirst = theValues;
+            }
+        }
+
+        return true;
+    }
+
+    std::string readFile(const std::string& aPath) {
+        std::ifstream theFile(aPath, std::ios::binary);
+        std::stringstream theContents;
+        theContents << theFile.rdbuf();
+        return theContents.str();
+    }
+
+    // Every input source, and every block size, must build the same model
+    bool runInputSourceTest(const std::string& aPath) {
+        for (const auto* theName : {"classroom.json", "sammy.json", "stripe.json"}) {
+            const std::string theFilePath = aPath + "/Resources/" + theName;
+            const std::string theDocument = readFile(theFilePath);
+
+            Model theExpected;
+            BufferSource theBuffer(theDocument);
+            assertWithMessage(JSONParser(theBuffer).parse(&theExpected), "Error parsing " + theFilePath);
+            const auto theExpectedOutput = theExpected.getRoot().toString();
+
+            Model theMapped;
+            MappedFileSource theMapping(theFilePath);
+            assertWithMessage(theMapping.isOpen(), "Could not map " + theFilePath);
+            assertWithMessage(JSONParser(theMapping).parse(&theMapped), "Error parsing mapped " + theFilePath);
+            assertWithMessage(theMapped.getRoot().toString() == theExpectedOutput, "Mapped file differs: " + theFilePath);
+
+            for (size_t theBlockSize = 1; theBlockSize <= 64; ++theBlockSize) {
+                std::istringstream theStream(theDocument);
+                StreamSource theSource(theStream, theBlockSize);
+                Model theModel;
+                assertWithMessage(JSONParser(theSource).parse(&theModel), "Error parsing " + theFilePath +
+                    " in blocks of " + std::to_string(theBlockSize));
+                assertWithMessage(theModel.getRoot().toString() == theExpectedOutput, "Blocks of " +
+                    std::to_string(theBlockSize) + " differ: " + theFilePath);
+            }
+        }
+
+        return true;
+    }
+
+    // Writes every parser event on its own line, so two parses can be compared exactly
+    class EventRecorder : public JSONListener {
+    public:
+        bool addKeyValuePair(const std::string& aKey, const std::string& aValue, Element aType) override {
+            return record("pair", aKey + "=" + aValue, aType);
+        }
+        bool addItem(const std::string& aValue, Element aType) override { return record("item", aValue, aType); }
+        bool openContainer(const std::string& aKey, Element aType) override { return record("open", aKey, aType); }
+        bool closeContainer(const std::string& aKey, Element aType) override { return record("close", aKey, aType); }
+
+        std::string events;
+
+    protected:
+        bool record(const char* anEvent, const std::string& aText, Element aType) {
+            events += std::string(anEvent) + " " + std::to_string(static_cast<int>(aType)) + " " + aText + "\n";
+            return true;
+        }
+    };
+
+    // Documents whose strings, escapes and constants land on awkward block boundaries
+    std::vector<std::string> getTrickyDocuments() {
+        std::vector<std::string> theDocuments{
+            R"({"a\"b": "c\\", "n": -5, "arr": [1, 2.5e3, true, false, null, "x,y:{}"], "o": {"k": []}, "e": {}})",
+            "\n\t {\"k\" : [ [ ], { } , \"\\\\\\\"\" ] , \"z\":tru , \"w\":xnull}\n",
+        };
+
+        for (size_t thePadding = 0; thePadding < 70; ++thePadding) {
+            std::string theDocument = "{\"" + std::string(thePadding, 'p') + "\": [";
+            for (size_t theEscapes = 0; theEscapes < 6; ++theEscapes)
+                theDocument += "\"" + std::string(2 * theEscapes, '\\') + "\\\"\", 12345, \"" + std::string(2 * theEscapes, '\\') + "\", ";
+            theDocument += "{\"last\": false}]}";
+            theDocument.insert(0, thePadding % 3, ' ');
+            theDocument.push_back('\n');
+            theDocuments.push_back(theDocument);
+        }
+        return theDocuments;
+    }
+
+    std::string recordEvents(const std::string& aDocument, ParseMode aMode, bool &isValid) {
+        EventRecorder theRecorder;
+        BufferSource theSource(aDocument);
+        isValid = JSONParser(theSource, aMode).parse(&theRecorder);
+        return theRecorder.events;
+    }
+
+    // The SIMD kernels must agree with the scalar one, and indexed parsing with streaming parsing
+    bool runIndexedParseTest(const std::string& aPath) {
+        std::string theNoise;
+        const char* kNoiseChars = "{}[]:,\"\\ a1\n";
+        for (size_t i = 0; i < 4096; ++i)
+            theNoise += kNoiseChars[(i * 7919 + i / 13) % 13];
+
+        std::vector<std::string> theDocuments = getTrickyDocuments();
+        for (const auto* theName : {"classroom.json", "sammy.json", "stripe.json"})
+            theDocuments.push_back(readFile(aPath + "/Resources/" + theName));
+        theDocuments.push_back(theNoise);
+
+        for (const auto& theDocument : theDocuments) {
+            StructuralIndex theExpected;
+            theExpected.build(theDocument, StructuralIndex::Kernel::scalar);
+            for (const auto theKernel : {StructuralIndex::Kernel::sse2, StructuralIndex::Kernel::avx2}) {
+                if (!StructuralIndex::isSupported(theKernel))
+                    continue;
+                StructuralIndex theIndex;
+                theIndex.build(theDocument, theKernel);
+                assertWithMessage(std::equal(theIndex.begin(), theIndex.end(), theExpected.begin(), theExpected.end()),
+                    std::string(StructuralIndex::getName(theKernel)) + " index differs from scalar for: " + theDocument);
+            }
+
+            if (&theDocument == &theNoise)
+                continue;
+
+            bool isStreamingValid = false, isIndexedValid = false;
+            const auto theStreaming = recordEvents(theDocument, ParseMode::streaming, isStreamingValid);
+            const auto theIndexed = recordEvents(theDocument, ParseMode::indexed, isIndexedValid);
+            assertWithMessage(isStreamingValid == isIndexedValid && theStreaming == theIndexed,
+                "Indexed parse differs for: " + theDocument + "\nExpected:\n" + theStreaming + "Got:\n" + theIndexed);
+        }
+
+        return true;
+    }
+
+    // A pushed document must produce the same events wherever it is split
+    bool runPushParserTest(const std::string& aPath) {
+        std::vector<std::string> theDocuments = getTrickyDocuments();
+        for (const auto* theName : {"classroom.json", "sammy.json", "stripe.json"})
+            theDocuments.push_back(readFile(aPath + "/Resources/" + theName));
+
+        for (const auto& theDocument : theDocuments) {
+            bool isExpectedValid = false;
+            const auto theExpected = recordEvents(theDocument, ParseMode::streaming, isExpectedValid);
+            const std::string_view theInput(theDocument);
+
+            for (size_t theSplit = 0; theSplit <= theInput.size(); ++theSplit) {
+                EventRecorder theRecorder;
+                JSONPushParser theParser(&theRecorder);
+                theParser.feed(theInput.substr(0, theSplit));
+                theParser.feed(theInput.substr(theSplit));
+                const bool isValid = theParser.finish();
+                assertWithMessage(isValid == isExpectedValid && theRecorder.events == theExpected,
+                    "Split at " + std::to_string(theSplit) + " differs for: " + theDocument +
+                    "\nExpected:\n" + theExpected + "Got:\n" + theRecorder.events);
+            }
+
+            EventRecorder theRecorder;
+            JSONPushParser theParser(&theRecorder);
+            for (const char theChar : theInput)
+                theParser.feed(&theChar, 1);
+            assertWithMessage(theParser.finish() == isExpectedValid && theRecorder.events == theExpected,
+                "Byte by byte feed differs for: " + theDocument);
+        }
+
+        const std::string theClassroom = readFile(aPath + "/Resources/classroom.json");
+        Model theExpected, thePushed;
+        BufferSource theSource(theClassroom);
+        JSONParser(theSource).parse(&theExpected);
+
+        JSONPushParser theParser(&thePushed);
+        for (size_t theOffset = 0; theOffset < theClassroom.size(); theOffset += 7)
+            theParser.feed(std::string_view(theClassroom).substr(theOffset, 7));
+        assertWithMessage(theParser.finish(), "Error pushing classroom.json into a Model");
+        assertWithMessage(thePushed.getRoot().toString() == theExpected.getRoot().toString(),
+            "Pushed Model differs from parsed Model");
+        return true;
+    }
+
+    // Records keep their order and errors their line numbers, whatever the thread count
+    bool runJSONLinesTest(const std::string& aPath) {
+        const std::string theSammy = readFile(aPath + "/Resources/sammy.json");
+        std::string theSammyLine = theSammy;
+        std::replace(theSammyLine.begin(), theSammyLine.end(), '\n', ' ');
+
+        std::string theLines;
+        std::vector<std::string> theExpected;
+        std::vector<size_t> theBadLines;
+        for (size_t i = 1; theLines.size() < 512 * 1024; ++i) {
+            if (i % 1000 == 7) {
+                theLines += "{\"broken\": [1, 2}\n";
+                theBadLines.push_back(i);
+            }
+            else if (i % 1000 == 500)
+                theLines += " \r\n"; // blank
+            else if (i % 1000 == 999) {
+                theLines += theSammyLine + "\r\n";
+                theExpected.push_back("sammy");
+            }
+            else if (i % 2) {
+                theLines += "{\"id\": " + std::to_string(i) + ", \"tags\": [\"a\", -1.5]}\n";
+                theExpected.push_back("{\"id\": " + std::to_string(i) + ", \"tags\": [\"a\", -1.500000]}");
+            }
+            else {
+                theLines += "[" + std::to_string(i) + ", {\"k\": null}]\n";
+                theExpected.push_back("[" + std::to_string(i) + ", {\"k\": null}]");
+            }
+        }
+        theLines += "{\"truncated\": ";
+        theBadLines.push_back(static_cast<size_t>(std::count(theLines.begin(), theLines.end(), '\n')) + 1);
+
+        Model theSammyModel;
+        BufferSource theSammySource(theSammy);
+        JSONParser(theSammySource).parse(&theSammyModel);
+        for (auto &theRecord : theExpected)
+            if ("sammy" == theRecord)
+                theRecord = theSammyModel.getRoot().toString();
+
+        for (const size_t theThreads : {1, 3, 8}) {
+            BufferSource theSource(theLines);
+            JSONLinesParser theParser(theSource, theThreads);
+            std::vector<Model> theModels;
+            assertWithMessage(!theParser.parse(theModels), "Invalid records were accepted");
+            assertWithMessage(theModels.size() == theExpected.size(), "Wrong record count with " +
+                std::to_string(theThreads) + " threads: " + std::to_string(theModels.size()));
+            for (size_t i = 0; i < theModels.size(); ++i)
+                assertWithMessage(theModels[i].getRoot().toString() == theExpected[i], "Record " + std::to_string(i) +
+                    " with " + std::to_string(theThreads) + " threads: " + theModels[i].getRoot().toString());
+
+            const auto &theErrors = theParser.getErrors();
+            assertWithMessage(theErrors.size() == theBadLines.size(), "Wrong error count");
+            for (size_t i = 0; i < theErrors.size(); ++i)
+                assertWithMessage(theErrors[i].line == theBadLines[i], "Error reported on line " +
+                    std::to_string(theErrors[i].line) + " instead of " + std::to_string(theBadLines[i]));
+        }
+
+        std::istringstream theStream(theSammyLine + "\n\n[1, 2]\n");
+        StreamSource theSource(theStream, 16);
+        Model theArray;
+        assertWithMessage(JSONLinesParser(theSource, 2).parse(theArray), "Error parsing JSON Lines into one Model");
+        const std::string theArrayExpected = "[" + theSammyModel.getRoot().toString() + ", [1, 2]]";
+        assertWithMessage(theArray.getRoot().toString() == theArrayExpected,
+            "Expected:\n" + theArrayExpected + "\nGot:\n" + theArray.getRoot().toString());
+        return true;
+    }
+
+    // Index built in pieces, with the state carried across each cut, must match the whole
+    bool checkChunkedIndex(const std::string& aDocument) {
+        StructuralIndex theExpected;
+        theExpected.build(aDocument);
 
+        for (size_t theCut = 1; theCut < aDocument.size(); theCut += 1 + theCut / 3) {
+            const std::string_view theFirst = std::string_view(aDocument).substr(0, theCut);
+            const bool isInString = StructuralIndex::flipsString(theFirst, false);
+
+            StructuralIndex theHead, theTail;
+            theHead.build(theFirst);
+            theTail.build(std::string_view(aDocument).substr(theCut), StructuralIndex::getCarry(aDocument, theCut, isInString));
+
+            std::vector<size_t> theOffsets(theHead.begin(), theHead.end());
+            for (const auto theOffset : theTail)
+                theOffsets.push_back(theCut + theOffset);
+            assertWithMessage(std::equal(theOffsets.begin(), theOffsets.end(), theExpected.begin(), theExpected.end()),
+                "Index cut at " + std::to_string(theCut) + " differs for: " + aDocument.substr(0, 200));
+        }
         return true;
     }
 
+    // Elements whose strings hide commas, brackets, quotes and backslashes
+    std::string generateElements(size_t aSize, size_t aSeed, bool isObject) {
+        std::string theElements;
+        for (size_t i = aSeed; theElements.size() < aSize; ++i) {
+            if (!theElements.empty())
+                theElements += ", ";
+            if (isObject)
+                theElements += "\"key" + std::to_string(i % 5000) + "\": ";
+            theElements += "{\"id\": " + std::to_string(i) + ", \"text\": \"a, b] {c} \\\"" + std::string(i % 4 * 2, '\\') +
+                           "\", \"values\": [" + std::to_string(i % 7) + ".5, -" + std::to_string(i) + ", null, [true]]}";
+        }
+        return theElements;
+    }
+
+    // Any thread count must give the Model a sequential parse gives
+    bool runParallelParseTest(const std::string& aPath) {
+        std::vector<std::string> theSmallDocuments = getTrickyDocuments();
+        for (const auto* theName : {"classroom.json", "sammy.json", "stripe.json"})
+            theSmallDocuments.push_back(readFile(aPath + "/Resources/" + theName));
+        for (const auto& theDocument : theSmallDocuments)
+            if (!checkChunkedIndex(theDocument))
+                return false;
+
+        const size_t kSize = ParallelParser::kMinParallelSize + 4096;
+        const std::string theSammy = readFile(aPath + "/Resources/sammy.json");
+        const std::vector<std::string> theDocuments{
+            "{\"records\": [" + generateElements(kSize, 0, false) + "], \"count\": 1}",
+            "[" + generateElements(kSize, 3, false) + "]",
+            "{" + generateElements(kSize, 5, true) + "}",
+            "{\"meta\": " + theSammy + ", \"data\": {\"rows\": [" + generateElements(kSize, 1, false) + "], \"n\": 2}}",
+            "[[" + generateElements(kSize / 2, 0, false) + "], [" + generateElements(kSize / 2, 9, false) + "]]",
+            "{\"records\": [" + generateElements(kSize, 0, false) + "}]}", // invalid
+        };
+
+        for (const auto& theDocument : theDocuments) {
+            Model theExpected;
+            BufferSource theSource(theDocument);
+            const bool isExpectedValid = JSONParser(theSource).parse(&theExpected);
+            const std::string theExpectedText = theExpected.getRoot().toString();
+
+            for (const size_t theThreads : {2, 3, 5}) {
+                Model theModel;
+                BufferSource theParallelSource(theDocument);
+                const bool isValid = ParallelParser(theParallelSource, theThreads).parse(theModel);
+                assertWithMessage(isValid == isExpectedValid && theModel.getRoot().toString() == theExpectedText,
+                    "Parallel parse with " + std::to_string(theThreads) + " threads differs for: " + theDocument.substr(0, 200));
+            }
+        }
+        return true;
+    }
+
+    // Node at a select path, walked the same way ModelQuery::select walks it
+    ModelNode* findNode(ModelNode* aRoot, const std::string& aPath) {
+        std::istringstream theSteps(aPath);
+        std::string theStep;
+        while (aRoot && std::getline(theSteps, theStep, '.')) {
+            if (theStep.size() >= 2 && '\'' == theStep.front())
+                theStep = theStep.substr(1, theStep.size() - 2);
+            if (ModelNode::Type::object == aRoot->getType())
+                aRoot = aRoot->find(theStep);
+            else if (ModelNode::Type::list == aRoot->getType())
+                aRoot = std::stoul(theStep) < aRoot->size() ? &aRoot->getItems()[std::stoul(theStep)] : nullptr;
+            else
+                aRoot = nullptr;
+        }
+        return aRoot;
+    }
+
+    std::string parseProjected(const std::string& aDocument, const Projection& aProjection, ParseMode aMode, size_t aBlockSize = 0) {
+        Model theModel;
+        std::istringstream theStream(aDocument);
+        StreamSource theStreamSource(theStream, aBlockSize ? aBlockSize : StreamSource::kDefaultBlockSize);
+        BufferSource theBufferSource(aDocument);
+        JSONParser theParser(aBlockSize ? static_cast<InputSource&>(theStreamSource) : theBufferSource, aMode);
+        theParser.setProjection(&aProjection);
+        return theParser.parse(&theModel) ? theModel.getRoot().toString() : "(parse failed)";
+    }
+
+    // A projected parse keeps exactly the selected paths, whatever the mode or block size
+    bool runProjectionTest(const std::string& aPath) {
+        const std::string theDocument = R"({"skip": {"a": "}]\"{", "b": [1, {"c": "\\"}]}, )"
+                                        R"("keep": [{"x": 1}, {"y": "]"}, 3, [4]], "tail": -1, "last": "x"})";
+        const Projection theProjection({"'keep'.1", "'tail'"});
+        const std::string theExpected = R"({"keep": [null, {"y": "]"}, null, null], "tail": -1})";
+
+        for (const auto theMode : {ParseMode::streaming, ParseMode::indexed}) {
+            const auto theResult = parseProjected(theDocument, theProjection, theMode);
+            assertWithMessage(theResult == theExpected, "Expected:\n" + theExpected + "\nGot:\n" + theResult);
+        }
+        for (size_t theBlockSize = 1; theBlockSize <= theDocument.size(); ++theBlockSize) {
+            const auto theResult = parseProjected(theDocument, theProjection, ParseMode::streaming, theBlockSize);
+            assertWithMessage(theResult == theExpected, "Blocks of " + std::to_string(theBlockSize) +
+                " expected:\n" + theExpected + "\nGot:\n" + theResult);
+        }
+
+        // steps that spell one list index differently reach the same item, so it keeps what each selects
+        const std::string theItems = R"({"a":[{"x":1,"y":2},{"x":3,"y":4}]})";
+        for (const auto& theSpellings : std::vector<std::vector<std::string>>{
+                {"'a'.1.'x'", "'a'.01.'y'"}, {"'a'.01.'y'", "'a'.1.'x'"}, {"'a'.1x.'y'", "'a'.1.'x'"}}) {
+            const Projection theItemProjection(theSpellings);
+            for (const auto theMode : {ParseMode::streaming, ParseMode::indexed}) {
+                Model theModel;
+                BufferSource theSource(theItems);
+                JSONParser theParser(theSource, theMode);
+                theParser.setProjection(&theItemProjection);
+                assertWithMessage(theParser.parse(&theModel), "Error parsing with " + theSpellings[0]);
+                for (const auto& theSelection : theSpellings) {
+                    const auto theValue = theModel.createQuery().select(theSelection).get("*");
+                    assertWithMessage(theValue == std::optional<std::string>(std::string::npos != theSelection.find("'x'") ? "3" : "4"),
+                        "Lost " + theSelection + " from " + theModel.getRoot().toString());
+                }
+            }
+        }
+
+        const std::string theStripe = readFile(aPath + "/Resources/stripe.json");
+        const std::vector<std::string> thePaths{"'data'.'object'.'metadata'", "'data'.'object'.'payment_method_types'.0", "'created'"};
+        const Projection theStripeProjection(thePaths);
+
+        Model theFull, theProjected;
+        BufferSource theFullSource(theStripe), theProjectedSource(theStripe);
+        JSONParser(theFullSource).parse(&theFull);
+        JSONParser theParser(theProjectedSource);
+        theParser.setProjection(&theStripeProjection);
+        assertWithMessage(theParser.parse(&theProjected), "Error parsing stripe.json with a projection");
+
+        for (const auto& theSelection : thePaths) {
+            const ModelNode *theWanted = findNode(&theFull.getRoot(), theSelection);
+            const ModelNode *theKept = findNode(&theProjected.getRoot(), theSelection);
+            assertWithMessage(theWanted && theKept && theWanted->toString() == theKept->toString(), "Lost " + theSelection);
+        }
+        const ModelNode &theRoot = theProjected.getRoot();
+        const ModelNode &theObject = *findNode(&theProjected.getRoot(), "'data'.'object'");
+        assertWithMessage(theRoot.size() == 2 && theObject.size() == 2, "Kept members nobody selected: " +
+            theProjected.getRoot().toString());
+
+        for (size_t theBlockSize = 1; theBlockSize <= 64; ++theBlockSize) {
+            assertWithMessage(parseProjected(theStripe, theStripeProjection, ParseMode::streaming, theBlockSize) ==
+                theProjected.getRoot().toString(), "Projected stripe.json differs in blocks of " + std::to_string(theBlockSize));
+        }
+        return true;
+    }
+
+    // Lazy models answer every query the way eager ones do, and only decode what queries visit
+    bool runLazyModelTest(const std::string& aPath) {
+        for (const auto* theTest : {"BasicTest", "AdvancedTest", "NoFilterTest"})
+            assertWithMessage(Autograder(aPath, ModelMode::lazy).runTest(theTest), std::string("Lazy ") + theTest + " failed");
+
+        for (const auto* theName : {"classroom.json", "sammy.json", "stripe.json"}) {
+            const std::string theDocument = readFile(aPath + "/Resources/" + theName);
+            Model theEager;
+            BufferSource theBuffer(theDocument);
+            JSONParser(theBuffer).parse(&theEager);
+            const std::string theExpected = theEager.getRoot().toString();
+
+            for (const auto theMode : {ParseMode::streaming, ParseMode::indexed}) {
+                Model theLazy(ModelMode::lazy);
+                BufferSource theSource(theDocument);
+                assertWithMessage(JSONParser(theSource, theMode).parse(&theLazy), std::string("Error parsing ") + theName);
+                assertWithMessage(theLazy.isLazy() && theLazy.getRoot().toString() == theExpected,
+                    std::string("Lazy model differs: ") + theName);
+            }
+            for (size_t theBlockSize = 1; theBlockSize <= 16; ++theBlockSize) {
+                Model theLazy(ModelMode::lazy);
+                std::istringstream theStream(theDocument);
+                StreamSource theSource(theStream, theBlockSize);
+                assertWithMessage(JSONParser(theSource).parse(&theLazy) && theLazy.getRoot().toString() == theExpected,
+                    std::string("Lazy model differs in blocks of ") + std::to_string(theBlockSize) + ": " + theName);
+            }
+        }
+
+        const std::string theDocument = R"([{"a": 1, "a": 2, "b": [2.0, 0.5, "s"]}, [[]], {"c": {}}, null])";
+        Model theLists(ModelMode::lazy), theEagerLists;
+        BufferSource theSource(theDocument), theEagerSource(theDocument);
+        assertWithMessage(JSONParser(theSource).parse(&theLists), "Error parsing a list root");
+        JSONParser(theEagerSource).parse(&theEagerLists);
+        const std::string theExpected = theEagerLists.getRoot().toString();
+        assertWithMessage(theLists.getRoot().toString() == theExpected, "Expected:\n" + theExpected +
+            "\nGot:\n" + theLists.getRoot().toString());
+
+        Model theStripe(ModelMode::lazy);
+        std::fstream theFile(aPath + "/Resources/stripe.json");
+        JSONParser(theFile).parse(&theStripe);
+        auto theQuery = theStripe.createQuery();
+        assertWithMessage(theQuery.select("'data'.'object'").get("'amount'").value_or("") == "2500", "Wrong amount");
+        const ModelNode *theRequest = findNode(&theStripe.getRoot(), "'request'");
+        assertWithMessage(theRequest && ModelNode::Type::deferred == theRequest->getType(),
+            "A container no query visited was decoded");
+
+        // queries on several threads expand the same deferred nodes, taking turns
+        std::string theWide = R"({"a": [)";
+        for (int i = 0; i < 200; ++i)
+            theWide += (i ? ", " : "") + std::string(R"({"x": )") + std::to_string(i) + R"(, "y": [)" + std::to_string(i) + "]}";
+        theWide += "]}";
+        for (int theRound = 0; theRound < 4; ++theRound) {
+            Model theShared(ModelMode::lazy);
+            BufferSource theWideSource(theWide);
+            JSONParser(theWideSource).parse(&theShared);
+            std::vector<char> isRight(4, false); // not vector<bool>, whose elements share bytes
+            std::vector<std::thread> theThreads;
+            for (size_t t = 0; t < isRight.size(); ++t) {
+                theThreads.emplace_back([&theShared, &isRight, t]() {
+                    auto theQuery = theShared.createQuery();
+                    bool isEach = 200 == theQuery.select("'a'").count();
+                    for (size_t i = t; i < 200; i += 7)
+                        isEach = isEach && theQuery.select("'a'." + std::to_string(i) + ".'y'").sum() == static_cast<double>(i);
+                    isRight[t] = isEach && theQuery.select("'a'.*.'x'").sum() == 19900;
+                });
+            }
+            for (auto& theThread : theThreads)
+                theThread.join();
+            assertWithMessage(std::all_of(isRight.begin(), isRight.end(), [](char isThreadRight) { return isThreadRight; }),
+                "Queries on several threads answered wrongly");
+        }
+
+        return true;
+    }
+
+    // Arenas hand out aligned memory, account for it, and live exactly as long as their last user
+    bool runArenaTest(const std::string& aPath) {
+        for (const bool useHugePages : {false, true}) {
+            Arena theArena(useHugePages);
+            for (size_t theSize = 1; theSize < 100000; theSize = theSize * 3 + 1) {
+                for (const size_t theAlignment : {1, 8, 16, 64}) {
+                    void *theMemory = theArena.allocate(theSize, theAlignment);
+                    assertWithMessage(reinterpret_cast<std::uintptr_t>(theMemory) % theAlignment == 0, "Misaligned allocation");
+                    std::memset(theMemory, 0x5a, theSize);
+                }
+            }
+            assertWithMessage(theArena.getUsed() > 0 && theArena.getReserved() >= theArena.getUsed(), "Wrong arena sizes");
+            theArena.release();
+            assertWithMessage(theArena.getReserved() == 0 && theArena.getUsed() == 0, "Release kept memory");
+        }
+
+        std::weak_ptr<Arena> theLastArena;
+        std::optional<ModelQuery> theQuery;
+        for (int i = 0; i < 20; ++i) { // reloading frees the previous document all at once
+            Model theModel;
+            std::fstream theFile(aPath + "/Resources/classroom.json");
+            assertWithMessage(JSONParser(theFile).parse(&theModel), "Error parsing classroom.json");
+            theQuery.reset();
+            assertWithMessage(theLastArena.expired(), "The previous document's arena is still alive");
+            assertWithMessage(theModel.getArena().getUsed() > 0, "The model allocated outside its arena");
+            theLastArena = theModel.shareArena();
+            theQuery.emplace(theModel.createQuery());
+        }
+        assertWithMessage(!theLastArena.expired(), "A query outlived its model's arena");
+        assertWithMessage(theQuery->select("'students'.0").get("'name'").value_or("") == "\"Micheal\"", "Wrong query result");
+        theQuery.reset();
+        assertWithMessage(theLastArena.expired(), "The last arena was never freed");
+
+        // Per-thread arenas stay with the Model that links their nodes in
+        std::string theLines;
+        for (int i = 0; i < 1000; ++i)
+            theLines += "{\"id\": " + std::to_string(i) + ", \"tags\": [\"a\", \"b\"]}\n";
+        Model theRecords;
+        BufferSource theSource(theLines);
+        assertWithMessage(JSONLinesParser(theSource, 4).parse(theRecords), "Error parsing JSON Lines");
+        assertWithMessage(theRecords.createQuery().select("999").get("'id'").value_or("") == "999", "Lost a record");
+        assertWithMessage(theRecords.getArena().getUsed() > theLines.size(), "Record arenas weren't kept");
+
+        return true;
+    }
+
+    // Document-order objects keep the order they were written in, through every way of building a Model
+    bool runKeyOrderTest([[maybe_unused]] const std::string& aPath) {
+        const std::string theDocument = R"({"b": 1, "a": {"z": 2, "y": 3}, "b": 4, "c": [{"q": 5, "p": 6}]})";
+        const std::string theSorted = R"({"a": {"y": 3, "z": 2}, "b": 1, "c": [{"p": 6, "q": 5}]})";
+        const std::string theWritten = R"({"b": 1, "a": {"z": 2, "y": 3}, "c": [{"q": 5, "p": 6}]})";
+        for (const auto theMode : {ModelMode::eager, ModelMode::lazy}) {
+            for (const auto theOrder : {KeyOrder::sorted, KeyOrder::document}) {
+                Model theModel(theMode, theOrder);
+                BufferSource theSource(theDocument);
+                assertWithMessage(JSONParser(theSource).parse(&theModel), "Error parsing a small object");
+                const std::string &theExpected = KeyOrder::sorted == theOrder ? theSorted : theWritten;
+                assertWithMessage(theModel.getRoot().toString() == theExpected, "Expected:\n" + theExpected +
+                    "\nGot:\n" + theModel.getRoot().toString());
+                assertWithMessage(theModel.createQuery().select("'c'.0").get("'p'").value_or("") == "6", "Wrong member");
+            }
+        }
+
+        // Wide enough for the hash index, and for the parallel parser to split
+        const size_t kWidth = 60000;
+        std::string theWide = "{";
+        for (size_t i = 0; i < kWidth; ++i) {
+            const size_t theKey = i * 7919 % kWidth;
+            theWide += "\"k" + std::to_string(theKey) + "\": " + std::to_string(theKey) + ", ";
+        }
+        theWide += "\"k0\": -1}"; // the first k0 wins
+
+        Model theExpected(ModelMode::eager, KeyOrder::document);
+        BufferSource theSource(theWide);
+        assertWithMessage(JSONParser(theSource).parse(&theExpected), "Error parsing a wide object");
+        const std::string theExpectedText = theExpected.getRoot().toString();
+        assertWithMessage(theExpectedText.rfind("{\"k0\": 0, \"k7919\": 7919, ", 0) == 0, "Wide object lost its order");
+
+        Model theLazy(ModelMode::lazy, KeyOrder::document), theParallel(ModelMode::eager, KeyOrder::document);
+        BufferSource theLazySource(theWide), theParallelSource(theWide);
+        assertWithMessage(JSONParser(theLazySource).parse(&theLazy) && theLazy.getRoot().toString() == theExpectedText,
+            "Lazy wide object differs");
+        assertWithMessage(ParallelParser(theParallelSource, 4).parse(theParallel) && theParallel.getRoot().toString() == theExpectedText,
+            "Parallel wide object differs");
+
+        ModelNode &theRoot = theExpected.getRoot();
+        assertWithMessage(theRoot.size() == kWidth, "Wrong member count");
+        for (size_t i = 0; i < kWidth; ++i) {
+            const ModelNode *theValue = theRoot.find("k" + std::to_string(i));
+            assertWithMessage(theValue && theValue->getInteger() == static_cast<long>(i), "Lookup failed for k" + std::to_string(i));
+        }
+        assertWithMessage(!theRoot.find("k" + std::to_string(kWidth)) && !theRoot.find(""), "Found a missing key");
+
+        std::string theLines = "{\"z\": 1, \"a\": 2}\n[{\"y\": 3, \"b\": 4}]\n";
+        Model theRecords;
+        BufferSource theLinesSource(theLines);
+        assertWithMessage(JSONLinesParser(theLinesSource, 2, KeyOrder::document).parse(theRecords) &&
+            theRecords.getRoot().toString() == R"([{"z": 1, "a": 2}, [{"y": 3, "b": 4}]])", "JSON Lines records lost their order");
+
+        return true;
+    }
+
+    // Compiled queries come back from the cache, least recently used out first, and run the same
+    bool runQueryCacheTest(const std::string& aPath) {
+        LRUCache<int, int> theNumbers(2);
+        theNumbers.insert(1, 10);
+        theNumbers.insert(2, 20);
+        assertWithMessage(theNumbers.find(1) && 10 == *theNumbers.find(1), "Lost a cached value");
+        theNumbers.insert(3, 30); // 2 is the least recent now
+        assertWithMessage(!theNumbers.find(2) && theNumbers.find(3) && theNumbers.size() == 2, "Evicted the wrong value");
+        theNumbers.insert(3, 31);
+        assertWithMessage(31 == *theNumbers.find(3) && theNumbers.size() == 2, "Replacing a value grew the cache");
+        assertWithMessage(theNumbers.getHits() == 4 && theNumbers.getMisses() == 1, "Wrong hit or miss count");
+
+        Model theModel;
+        std::fstream theFile(aPath + "/Resources/classroom.json");
+        JSONParser(theFile).parse(&theModel);
+
+        const std::vector<std::string> theQueries{
+            "select('location').get('roomNumber')", "select('students').filter(index > 1).count()",
+            "select('students').get(*)", "select('students'.3).get('grade')", "select('nope').get('x')", "shout('hi')"};
+        std::vector<std::optional<std::string>> theExpected;
+        for (const auto& theQuery : theQueries)
+            theExpected.push_back(CommandProcessor(theModel).process(theQuery));
+
+        const auto theCache = std::make_shared<CommandProcessor::PlanCache>(CommandProcessor::kDefaultCacheSize);
+        for (int theRound = 0; theRound < 3; ++theRound) {
+            for (size_t i = 0; i < theQueries.size(); ++i)
+                assertWithMessage(CommandProcessor(theModel, theCache).process(theQueries[i]) == theExpected[i],
+                    "A cached plan gave a different result for " + theQueries[i]);
+        }
+        assertWithMessage(theCache->getMisses() == theQueries.size() && theCache->getHits() == 2 * theQueries.size(),
+            "Queries were compiled more than once");
+
+        // a batch answers as each query would alone, whatever order its walk takes
+        std::vector<std::string> theBatch(theQueries);
+        theBatch.insert(theBatch.end(), {"select('students'.3).get('name')", "select('nope').count()", "count()",
+            "select('students'.*).filter('grade' > 80).count()", "select('students'.3)", "select('location'.'nope').sum()",
+            "select('').get('location')", "select('students'.0).get('name')", "select('students').filter(index > 1)",
+            "select('location').count()"});
+        for (int theRound = 0; theRound < 2; ++theRound) {
+            const auto theOutputs = CommandProcessor(theModel, theCache).processBatch(theBatch);
+            assertWithMessage(theOutputs.size() == theBatch.size(), "A batch lost answers");
+            for (size_t i = 0; i < theBatch.size(); ++i)
+                assertWithMessage(theOutputs[i] == CommandProcessor(theModel).process(theBatch[i]),
+                    "A batch answered differently for " + theBatch[i]);
+            std::reverse(theBatch.begin(), theBatch.end());
+        }
+
+        // a query that ends in a filter leaves nothing behind for the next one
+        Model theLists;
+        BufferSource theListSource(R"({"a":[1,2,3,4],"b":[10,20,30]})");
+        JSONParser(theListSource).parse(&theLists);
+        std::vector<std::string> theFiltered{"select('b').filter(index > 1)", "select('a').count()"};
+        for (int theRound = 0; theRound < 2; ++theRound) {
+            const auto theOutputs = CommandProcessor(theLists).processBatch(theFiltered);
+            const size_t theCounted = theRound ? 0 : 1; // where the count() landed
+            assertWithMessage(theOutputs[theCounted] == std::optional<std::string>("4"),
+                "A filter carried over to the next query in a batch");
+            std::reverse(theFiltered.begin(), theFiltered.end());
+        }
+
+        return true;
+    }
+
+    // Every path into aNode, as select() writes them; keys a path can't spell are left out
+    void addQueryPaths(const ModelNode &aNode, const std::string &aPath, std::vector<std::string> &aPaths) {
+        aPaths.push_back(aPath);
+        const std::string thePrefix = aPath.empty() ? "" : aPath + ".";
+        if (ModelNode::Type::list == aNode.getType()) {
+            for (size_t i = 0; i < aNode.size(); ++i)
+                addQueryPaths(aNode.getItems()[i], thePrefix + std::to_string(i), aPaths);
+        }
+        else if (ModelNode::Type::object == aNode.getType()) {
+            for (size_t i = 0; i < aNode.size(); ++i) {
+                const auto &theMember = aNode.getMembers()[i];
+                const std::string theKey(theMember.key.getString());
+                if (theKey.find_first_of(".'\\") == std::string::npos)
+                    addQueryPaths(theMember.value, thePrefix + "'" + theKey + "'", aPaths);
+            }
+        }
+    }
+
+    // Streamed queries answer as queries of a Model do, and stop reading once they can
+    bool runStreamingQueryTest(const std::string& aPath) {
+        for (const auto* theName : {"classroom.json", "sammy.json", "stripe.json"}) {
+            const std::string theDocument = readFile(aPath + "/Resources/" + theName);
+            Model theModel;
+            BufferSource theSource(theDocument);
+            JSONParser(theSource).parse(&theModel);
+
+            std::vector<std::string> thePaths;
+            addQueryPaths(theModel.getRoot(), "", thePaths);
+            thePaths.insert(thePaths.end(), {"'nope'", "0", "'data'.'nope'.'x'", "'students'.99", "'students'.'x'", "'students'.-1"});
+            std::vector<std::string> theQueries;
+            for (const auto &thePath : thePaths) {
+                for (const auto* theConsumer : {"count()", "sum()", "min()", "max()", "avg()", "get(*)", "get('id')", "get(0)", "get()"})
+                    theQueries.push_back("select(" + thePath + ")." + theConsumer);
+            }
+            theQueries.insert(theQueries.end(), {"select('students').filter(index > 1).count()", "count()",
+                                                 "select('students'.*.'grade').sum()", "shout('hi')"});
+
+            for (const auto &theQuery : theQueries) {
+                const auto theExpected = CommandProcessor(theModel).process(theQuery);
+                BufferSource theStreamed(theDocument);
+                assertWithMessage(CommandProcessor::processStream(theQuery, theStreamed) == theExpected,
+                    std::string(theName) + ": streaming " + theQuery + " gave a different answer than " + theExpected.value_or("nullopt"));
+            }
+            for (size_t theBlockSize = 1; theBlockSize <= 16; ++theBlockSize) {
+                const std::string &theQuery = theQueries[theQueries.size() / 2];
+                std::istringstream theStream(theDocument);
+                StreamSource theStreamed(theStream, theBlockSize);
+                assertWithMessage(CommandProcessor::processStream(theQuery, theStreamed) == CommandProcessor(theModel).process(theQuery),
+                    std::string(theName) + ": streaming " + theQuery + " differs in blocks of " + std::to_string(theBlockSize));
+            }
+        }
+
+        // Model keeps the first of a repeated key, and sums in blocks of the same size
+        std::string theDocument = R"({"a": 1, "a": 2, "b": {"x": 1.5, "x": 5, "y": 2, "z": [1]}, "c": [)";
+        for (size_t i = 0; i < 2 * ModelQuery::kReductionBlock + 5; ++i)
+            theDocument += std::to_string(i % 7) + ".1, \"s\", ";
+        theDocument += "null]}";
+        Model theModel;
+        BufferSource theSource(theDocument);
+        JSONParser(theSource).parse(&theModel);
+        for (const auto* theQuery : {"select('a').get(*)", "select('b').count()", "select('b').sum()", "select('b').get(*)",
+                                     "select('c').count()", "select('c').sum()", "select('c').avg()", "select('c').max()",
+                                     "select('c'.9).get(*)", "select('b').get('z')"}) {
+            BufferSource theStreamed(theDocument);
+            assertWithMessage(CommandProcessor::processStream(theQuery, theStreamed) == CommandProcessor(theModel).process(theQuery),
+                std::string("Streaming ") + theQuery + " gave a different answer");
+        }
+
+        // An answer near the start doesn't wait for the rest, even when the rest is broken...
+        std::istringstream theEarly(R"({"first": {"id": 7}, "rest": [)" + std::string(1 << 16, ' ') + "1, 2, ");
+        StreamSource theEarlySource(theEarly, 64);
+        assertWithMessage(CommandProcessor::processStream("select('first').get('id')", theEarlySource) == "7",
+            "An early answer wasn't found");
+        assertWithMessage(theEarly.tellg() > 0 && theEarly.tellg() < 1024, "Kept reading after the answer was final");
+        const std::string theTop = R"({"first": {"id": 7}, "rest": [1, 2, 3]})";
+        StreamingQuery theTopQuery(QueryPath("'first'.'id'"), StreamingQuery::Consumer::get);
+        BufferSource theTopSource(theTop);
+        assertWithMessage(theTopQuery.run(theTopSource) && theTopQuery.get() == "7" &&
+                          theTopQuery.getBytesConsumed() == theTop.find('7') + 1, "Didn't stop right after the answer");
+
+        // ...but input that breaks before the answer gives none
+        BufferSource theBroken(R"({"a": {"b": [1, tru]}, "c": 3})"), theCutOff(R"({"a": [1, 2], "c": )");
+        assertWithMessage(!CommandProcessor::processStream("select('a'.'b').count()", theBroken) &&
+                          !CommandProcessor::processStream("select('c').get(*)", theCutOff), "Answered from invalid input");
+        return true;
+    }
+
+    // Records view events along with their escape flags
+    class ViewRecorder : public JSONViewListener {
+    public:
+        bool addKeyValuePair(std::string_view aKey, std::string_view aValue, Element, bool isEscaped) override {
+            events += std::string(aKey) + "=" + std::string(aValue) + (isEscaped ? " (escaped)\n" : "\n");
+            return true;
+        }
+        bool addItem(std::string_view aValue, Element, bool isEscaped) override {
+            events += std::string(aValue) + (isEscaped ? " (escaped)\n" : "\n");
+            return true;
+        }
+        bool openContainer(std::string_view aKey, Element) override {
+            events += std::string(aKey) + "{\n";
+            return true;
+        }
+        bool closeContainer(std::string_view aKey, Element) override {
+            events += "}" + std::string(aKey) + "\n";
+            return true;
+        }
+        bool addInteger(std::string_view aKey, std::int64_t aValue) override {
+            return recordConstant(aKey, "int:" + std::to_string(aValue));
+        }
+        bool addDouble(std::string_view aKey, double aValue) override {
+            std::ostringstream theText;
+            theText << "double:" << aValue;
+            return recordConstant(aKey, theText.str());
+        }
+        bool addBool(std::string_view aKey, bool aValue) override {
+            return recordConstant(aKey, aValue ? "bool:true" : "bool:false");
+        }
+        bool addNull(std::string_view aKey) override { return recordConstant(aKey, "null"); }
+
+        std::string events;
+
+    protected:
+        bool recordConstant(std::string_view aKey, const std::string& aText) {
+            events += (aKey.empty() ? "" : std::string(aKey) + "=") + aText + "\n";
+            return true;
+        }
+    };
+
+    // Records events until a container with aKey closes, and then stops the parse
+    class StoppingRecorder : public ViewRecorder {
+    public:
+        explicit StoppingRecorder(std::string_view aKey) : stopKey(aKey) {}
+
+        bool closeContainer(std::string_view aKey, Element aType) override {
+            ViewRecorder::closeContainer(aKey, aType);
+            hasStopped = aKey == stopKey;
+            return !hasStopped;
+        }
+        bool isDone() const override { return hasStopped; }
+
+    protected:
+        std::string stopKey;
+        bool hasStopped = false;
+    };
+
+    // Done as soon as the root opens
+    class OpeningStopper : public ViewRecorder {
+    public:
+        bool openContainer(std::string_view aKey, Element aType) override {
+            ViewRecorder::openContainer(aKey, aType);
+            return false;
+        }
+        bool isDone() const override { return true; }
+    };
+
+    // A listener that is done ends the parse there, successfully, whatever the rest of the input holds
+    bool runStopSignalTest() {
+        const std::string theDocument = R"({"head": {"id": 1}, "tail": [1, 2, 3], "broken": [tru]})";
+        const std::string theExpected = "{\nhead{\nid=int:1\n}head\n";
+        const size_t theStop = theDocument.find('}') + 1;
+
+        for (const auto theMode : {ParseMode::streaming, ParseMode::indexed}) {
+            StoppingRecorder theRecorder("head");
+            BufferSource theSource(theDocument);
+            JSONParser theParser(theSource, theMode);
+            assertWithMessage(theParser.parse(&theRecorder) && theParser.wasStopped(), "A stopped parse failed");
+            assertWithMessage(theRecorder.events == theExpected && theParser.getBytesConsumed() == theStop,
+                "Stopped at " + std::to_string(theParser.getBytesConsumed()) + " after:\n" + theRecorder.events);
+
+            StoppingRecorder theUnstopped("nope");
+            BufferSource theBrokenSource(theDocument);
+            JSONParser theBrokenParser(theBrokenSource, theMode);
+            assertWithMessage(!theBrokenParser.parse(&theUnstopped) && !theBrokenParser.wasStopped(), "Invalid document accepted");
+
+            OpeningStopper theOpening;
+            BufferSource theRootSource("  [1, 2, 3]");
+            JSONParser theRootParser(theRootSource, theMode);
+            assertWithMessage(theRootParser.parse(&theOpening) && theRootParser.wasStopped() && 3 == theRootParser.getBytesConsumed(),
+                "Stopped at the root's opening after " + std::to_string(theRootParser.getBytesConsumed()) + " bytes");
+        }
+        for (size_t theBlockSize = 1; theBlockSize <= theDocument.size(); ++theBlockSize) {
+            StoppingRecorder theRecorder("head");
+            std::istringstream theStream(theDocument);
+            StreamSource theSource(theStream, theBlockSize);
+            JSONParser theParser(theSource);
+            assertWithMessage(theParser.parse(&theRecorder) && theRecorder.events == theExpected &&
+                              theParser.getBytesConsumed() == theStop, "Stopped wrongly in blocks of " + std::to_string(theBlockSize));
+            assertWithMessage(theStream.tellg() <= static_cast<std::streamoff>(theStop + theBlockSize),
+                "Kept reading in blocks of " + std::to_string(theBlockSize));
+
+            StoppingRecorder thePushed("head");
+            JSONPushParser thePushParser(&thePushed);
+            bool isValid = true;
+            for (size_t i = 0; i < theDocument.size(); i += theBlockSize)
+                isValid = thePushParser.feed(std::string_view(theDocument).substr(i, theBlockSize)) && isValid;
+            assertWithMessage(isValid && thePushParser.finish() && thePushParser.wasStopped() &&
+                              thePushed.events == theExpected && thePushParser.getBytesConsumed() == theStop,
+                "Pushed parse stopped wrongly in blocks of " + std::to_string(theBlockSize));
+        }
+        return true;
+    }
+
+    // Constants reach a JSONViewListener already converted, and Model keeps whole numbers as longs
+    bool runTypedConstantTest() {
+        const std::string theDocument = R"({"i": -42, "max": 9223372036854775807, "over": 9223372036854775808, )"
+                                        R"("d": -2.5e-3, "e": 1E3, "list": [true, false, null, 0.5, -0]})";
+        const std::string theExpected = "{\ni=int:-42\nmax=int:9223372036854775807\nover=double:9.22337e+18\n"
+                                        "d=double:-0.0025\ne=double:1000\nlist{\nbool:true\nbool:false\nnull\n"
+                                        "double:0.5\nint:0\n}list\n}\n";
+
+        for (const auto theMode : {ParseMode::streaming, ParseMode::indexed}) {
+            ViewRecorder theRecorder;
+            BufferSource theSource(theDocument);
+            assertWithMessage(JSONParser(theSource, theMode).parse(&theRecorder), "Error parsing constants");
+            assertWithMessage(theRecorder.events == theExpected, "Expected:\n" + theExpected + "Got:\n" + theRecorder.events);
+
+            for (const auto* theConstant : {"tru", "nan", "-infinity", "inf", "007", "-01", "1.", ".5", "+1", "1e", "1e+", "--1", "0x10"}) {
+                const std::string theInvalidDocument = std::string(R"({"x": )") + theConstant + "}"; // outlives the source's view
+                ViewRecorder theRejected;
+                BufferSource theInvalid(theInvalidDocument);
+                assertWithMessage(!JSONParser(theInvalid, theMode).parse(&theRejected),
+                    std::string("Accepted the invalid constant ") + theConstant);
+                bool isValid = true;
+                recordEvents(theInvalidDocument, theMode, isValid);
+                assertWithMessage(!isValid, std::string("A JSONListener was given the invalid constant ") + theConstant);
+            }
+        }
+
+        Model theModel;
+        std::istringstream theStream(theDocument);
+        assertWithMessage(JSONParser(theStream).parse(&theModel), "Error parsing constants into a Model");
+        const std::string theModelExpected = "{\"d\": -0.002500, \"e\": 1000, \"i\": -42, \"list\": [true, false, null, "
+                                             "0.500000, 0], \"max\": 9223372036854775807, \"over\": 9223372036854775808.000000}";
+        assertWithMessage(theModel.getRoot().toString() == theModelExpected,
+            "Expected:\n" + theModelExpected + "\nGot:\n" + theModel.getRoot().toString());
+        return true;
+    }
+
+    // Views and escape flags must not depend on the parse mode or on where blocks end
+    bool runViewListenerTest([[maybe_unused]] const std::string& aPath) {
+        const std::string theDocument = R"({"plain": "text", "newline": "a\nb", "inner": {"list": ["x\"y", 5, "z"]}})";
+        const std::string theExpected = "{\nplain=text\nnewline=a\\nb (escaped)\ninner{\nlist{\n"
+                                        "x\\\"y (escaped)\nint:5\nz\n}list\n}inner\n}\n";
+
+        for (const auto theMode : {ParseMode::streaming, ParseMode::indexed}) {
+            ViewRecorder theRecorder;
+            BufferSource theSource(theDocument);
+            assertWithMessage(JSONParser(theSource, theMode).parse(&theRecorder), "Error parsing views");
+            assertWithMessage(theRecorder.events == theExpected, "Expected:\n" + theExpected + "Got:\n" + theRecorder.events);
+        }
+
+        ViewRecorder theDirectRecorder;
+        BufferSource theDirectSource(theDocument);
+        assertWithMessage(BasicJSONParser<ViewRecorder>(theDirectSource).parse(&theDirectRecorder) &&
+                          theDirectRecorder.events == theExpected, "BasicJSONParser<ViewRecorder> events differ");
+
+        NullListener theNullListener;
+        BufferSource theValidSource(theDocument), theInvalidSource(R"({"a": [1, 2})");
+        assertWithMessage(BasicJSONParser<NullListener>(theValidSource).parse(&theNullListener), "Valid document rejected");
+        assertWithMessage(!BasicJSONParser<NullListener>(theInvalidSource).parse(&theNullListener), "Invalid document accepted");
+
+        for (size_t theBlockSize = 1; theBlockSize <= theDocument.size(); ++theBlockSize) {
+            ViewRecorder theRecorder;
+            std::istringstream theStream(theDocument);
+            StreamSource theSource(theStream, theBlockSize);
+            assertWithMessage(JSONParser(theSource).parse(&theRecorder), "Error parsing views");
+            assertWithMessage(theRecorder.events == theExpected, "Blocks of " + std::to_string(theBlockSize) +
+                " expected:\n" + theExpected + "Got:\n" + theRecorder.events);
+        }
+
+        return runTypedConstantTest() && runStopSignalTest();
+    }
+
     // ---Autograder---
 
-    Autograder::Autograder(const std::string& aWorkingDirectoryPath)
-        : workingDirectory(aWorkingDirectoryPath) {
+    Autograder::Autograder(const std::string& aWorkingDirectoryPath, ModelMode aMode)
+        : workingDirectory(aWorkingDirectoryPath), mode(aMode),
+          planCache(std::make_shared<CommandProcessor::PlanCache>(CommandProcessor::kDefaultCacheSize)) {
     }
 
     bool Autograder::runTest(const std::string& aTestName) {
         if (!openFiles(aTestName))
             return false;
 
-        Model theModel;
+        Model theModel(mode);
         if (!parseJson(theModel))
             return false;
 
@@ -111,17 +1234,25 @@ namespace JSONProc {
     }
 
     bool Autograder::runCommands(Model& aModel) {
-        std::string theQuery;
-        while (std::getline(testFile, theQuery)) {
-            CommandProcessor theProcessor(aModel);
-            auto theOutput = theProcessor.process(theQuery).value_or("~~empty~~");
+        std::vector<std::string> theQueries;
+        for (std::string theQuery; std::getline(testFile, theQuery);)
+            theQueries.push_back(theQuery);
+
+        // every line answered in one walk, then each answer checked against one of its own
+        CommandProcessor theProcessor(aModel, planCache);
+        const auto theOutputs = theProcessor.processBatch(theQueries);
+        for (size_t i = 0; i < theQueries.size(); ++i) {
+            auto theOutput = theOutputs[i].value_or("~~empty~~");
             removeWhitespace(theOutput);
 
-            auto theExpectedOutput = getExpectedOutput(theQuery);
+            auto theAlone = CommandProcessor(aModel, planCache).process(theQueries[i]).value_or("~~empty~~");
+            removeWhitespace(theAlone);
+
+            auto theExpectedOutput = getExpectedOutput(theQueries[i]);
             removeWhitespace(theExpectedOutput);
 
-            assertWithMessage(theOutput == theExpectedOutput, "Test failed: '" + theQuery +
-                "'\nExpected: '" + theExpectedOutput + "', got: '" + theOutput + "'");
+            assertWithMessage(theOutput == theExpectedOutput && theAlone == theExpectedOutput, "Test failed: '" + theQueries[i] +
+                "'\nExpected: '" + theExpectedOutput + "', got: '" + theOutput + "' in a batch, '" + theAlone + "' alone");
         }
 
         return true;
@@ -166,8 +1297,21 @@ namespace JSONProc {
     std::string StringIterator::extractValueFromParenthesis() {
         ASSERT(getRemainingLength() > 0);
         ASSERT(string[index] == '(');
-        const auto theEndPosition = string.find(')', index);
-        ASSERT(theEndPosition != std::string::npos);
+        //the matching parenthesis, so filter conditions can group with their own
+        size_t theEndPosition = index;
+        char theQuote = 0;
+        for (size_t theDepth = 0; theEndPosition < string.length(); ++theEndPosition) {
+            const char theChar = string[theEndPosition];
+            if (theQuote)
+                theQuote = theChar == theQuote ? 0 : theQuote;
+            else if ('\'' == theChar || '"' == theChar)
+                theQuote = theChar;
+            else if ('(' == theChar)
+                ++theDepth;
+            else if (')' == theChar && 0 == --theDepth)
+                break;
+        }
+        ASSERT(theEndPosition < string.length());
 
         const auto theStartPosition = index + 1;
         const auto theLength = theEndPosition - index;
@@ -182,26 +1326,133 @@ namespace JSONProc {
 
     // ---CommandProcessor---
 
-    CommandProcessor::CommandProcessor(Model& aModel) : modelQuery(aModel.createQuery()) {
+    CommandProcessor::CommandProcessor(Model& aModel, std::shared_ptr<PlanCache> aCache)
+        : modelQuery(aModel.createQuery()),
+          cache(aCache ? std::move(aCache) : std::make_shared<PlanCache>(kDefaultCacheSize)) {
+    }
+
+    std::shared_ptr<const CommandProcessor::Plan> CommandProcessor::getPlan(const std::string& aQuery) {
+        const auto *theCached = cache->find(aQuery);
+        return theCached ? *theCached : cache->insert(aQuery, compile(aQuery));
     }
 
     std::optional<std::string> CommandProcessor::process(const std::string& aQuery) {
-        StringIterator theIterator(aQuery);
+        const std::shared_ptr<const Plan> thePlan = getPlan(aQuery);
+        if (!thePlan->isValid) {
+            std::clog << "Invalid command type in query: '" << aQuery << "'\n";
+            return std::nullopt;
+        }
+
         std::optional<std::string> theOutput = std::nullopt;
+        for (const auto& theCommand : thePlan->commands)
+            theOutput = callCommand(theCommand);
+        return theOutput;
+    }
+
+    std::vector<std::optional<std::string>> CommandProcessor::processBatch(const std::vector<std::string>& aQueries) {
+        std::vector<std::optional<std::string>> theOutputs(aQueries.size());
+        std::vector<std::shared_ptr<const Plan>> thePlans; // the queries that start with a select
+        std::vector<const QueryPath*> thePaths;
+        std::vector<size_t> thePositions;
+        for (size_t i = 0; i < aQueries.size(); ++i) {
+            auto thePlan = getPlan(aQueries[i]);
+            if (!thePlan->isValid || thePlan->commands.empty() || CommandType::select != thePlan->commands.front().type) {
+                theOutputs[i] = process(aQueries[i]);
+                continue;
+            }
+            thePaths.push_back(&thePlan->commands.front().path);
+            thePositions.push_back(i);
+            thePlans.push_back(std::move(thePlan));
+        }
+
+        // the rest of each query runs where the shared walk selected its path
+        modelQuery.selectEach(thePaths, [&](size_t aPath) {
+            const auto &theCommands = thePlans[aPath]->commands;
+            std::optional<std::string> theOutput = std::nullopt;
+            for (size_t i = 1; i < theCommands.size(); ++i)
+                theOutput = callCommand(theCommands[i]);
+            theOutputs[thePositions[aPath]] = std::move(theOutput);
+        });
+        return theOutputs;
+    }
+
+    // get() with an empty path prints the root, so it needs all of the document anyway
+    bool isWholeDocument(const CommandProcessor::Command& aCommand) {
+        return CommandProcessor::CommandType::get == aCommand.type && "*" != aCommand.parameter && aCommand.path.empty();
+    }
+
+    std::optional<std::string> CommandProcessor::processStream(const std::string& aQuery, InputSource& aSource) {
+        const std::shared_ptr<const Plan> thePlan = compile(aQuery);
+        const auto &theCommands = thePlan->commands;
+        const bool isStreamable = thePlan->isValid && 2 == theCommands.size() &&
+                                  CommandType::select == theCommands[0].type && !theCommands[0].path.selectsSet() &&
+                                  CommandType::select != theCommands[1].type && CommandType::filter != theCommands[1].type &&
+                                  !theCommands[1].path.selectsSet() && !isWholeDocument(theCommands[1]);
+        if (!isStreamable) {
+            Model theModel;
+            if (!BasicJSONParser<Model>(aSource).parse(&theModel))
+                return std::nullopt;
+            return CommandProcessor(theModel).process(aQuery);
+        }
+
+        // get() steps on from the selection
+        const Command &theConsumer = theCommands[1];
+        std::string thePath = theCommands[0].parameter;
+        if (CommandType::get == theConsumer.type && "*" != theConsumer.parameter)
+            thePath = thePath.empty() ? theConsumer.parameter : thePath + "." + theConsumer.parameter;
+
+        StreamingQuery::Consumer theKind = StreamingQuery::Consumer::get;
+        switch (theConsumer.type) {
+            case CommandType::count: theKind = StreamingQuery::Consumer::count; break;
+            case CommandType::sum:   theKind = StreamingQuery::Consumer::sum; break;
+            case CommandType::min:   theKind = StreamingQuery::Consumer::min; break;
+            case CommandType::max:   theKind = StreamingQuery::Consumer::max; break;
+            case CommandType::avg:   theKind = StreamingQuery::Consumer::avg; break;
+            default: break;
+        }
+
+        StreamingQuery theQuery(QueryPath(thePath), theKind);
+        if (!theQuery.run(aSource))
+            return std::nullopt;
+
+        switch (theConsumer.type) {
+            case CommandType::count:
+                return std::to_string(theQuery.count());
+            case CommandType::sum:
+                return doubleToString(theQuery.sum());
+            case CommandType::get:
+                return theQuery.get();
+            default: {
+                const auto theValue = CommandType::min == theConsumer.type ? theQuery.min()
+                                    : CommandType::max == theConsumer.type ? theQuery.max() : theQuery.avg();
+                return theValue ? std::optional<std::string>(doubleToString(*theValue)) : std::nullopt;
+            }
+        }
+    }
+
+    std::shared_ptr<const CommandProcessor::Plan> CommandProcessor::compile(const std::string& aQuery) {
+        StringIterator theIterator(aQuery);
+        auto thePlan = std::make_shared<Plan>();
 
         do {
             const auto theCommandType = getCommandType(theIterator);
             if (theCommandType == CommandType::invalid) {
-                std::clog << "Invalid command type in query: '" << aQuery << "'\n";
-                return std::nullopt;
+                thePlan->isValid = false;
+                break;
             }
 
-            const auto theParameters = theIterator.extractValueFromParenthesis();
-            theOutput = callCommand(theCommandType, theParameters);
+            Command theCommand{theCommandType, theIterator.extractValueFromParenthesis(), {}, {}};
+            const bool hasPath = CommandType::select == theCommandType ||
+                                 (CommandType::get == theCommandType && "*" != theCommand.parameter);
+            if (hasPath)
+                theCommand.path = QueryPath(theCommand.parameter);
+            else if (CommandType::filter == theCommandType)
+                theCommand.filter = filterPolicy(theCommand.parameter);
+            thePlan->commands.push_back(std::move(theCommand));
 
         } while (theIterator.matchesCharacter('.'));
 
-        return theOutput;
+        return thePlan;
     }
 
     CommandProcessor::CommandType CommandProcessor::getCommandType(StringIterator& anIterator) {
@@ -212,15 +1463,15 @@ namespace JSONProc {
         return CommandType::invalid;
     }
 
-    std::optional<std::string> CommandProcessor::callCommand(const CommandType aType, const std::string& aParameter) {
-        switch (aType)
+    std::optional<std::string> CommandProcessor::callCommand(const Command& aCommand) {
+        switch (aCommand.type)
         {
         case CommandType::select:
-            modelQuery.select(aParameter);
+            modelQuery.select(aCommand.path);
             break;
 
         case CommandType::filter:
-            modelQuery.filter(aParameter);
+            modelQuery.filter(aCommand.filter);
             break;
 
         case CommandType::count:
@@ -229,8 +1480,18 @@ namespace JSONProc {
         case CommandType::sum:
             return doubleToString(modelQuery.sum());
 
+        case CommandType::min:
+        case CommandType::max:
+        case CommandType::avg: {
+            const auto theValue = CommandType::min == aCommand.type ? modelQuery.min()
+                                : CommandType::max == aCommand.type ? modelQuery.max() : modelQuery.avg();
+            return theValue ? std::optional<std::string>(doubleToString(*theValue)) : std::nullopt;
+        }
+
         case CommandType::get:
-            return modelQuery.get(aParameter);
+            if ("*" == aCommand.parameter)
+                return modelQuery.get(aCommand.parameter);
+            return modelQuery.get(aCommand.path);
 
         default:
             break;
@@ -7,30 +7,26 @@
 #include <string>
 #include <fstream>
 #include <array>
+#include <memory>
+#include <vector>
+#include "LRUCache.h"
 #include "Model.h"
 
 namespace JSONProc {
 
     bool runModelQueryTest(const std::string& aPath);
-
-    class Autograder {
-    public:
-        Autograder(const std::string& aWorkingDirectoryPath);
-
-        bool runTest(const std::string& aTestName);
-
-    protected:
-        bool openFiles(const std::string& aTestName);
-        bool parseJson(Model& aModel);
-
-        bool runCommands(Model& aModel);
-
-        std::string getExpectedOutput(const std::string& aQuery);
-
-        std::string workingDirectory;
-        std::fstream testFile, jsonFile;
-
-    };
+    bool runInputSourceTest(const std::string& aPath);
+    bool runIndexedParseTest(const std::string& aPath);
+    bool runViewListenerTest(const std::string& aPath);
+    bool runPushParserTest(const std::string& aPath);
+    bool runJSONLinesTest(const std::string& aPath);
+    bool runParallelParseTest(const std::string& aPath);
+    bool runProjectionTest(const std::string& aPath);
+    bool runLazyModelTest(const std::string& aPath);
+    bool runArenaTest(const std::string& aPath);
+    bool runKeyOrderTest(const std::string& aPath);
+    bool runQueryCacheTest(const std::string& aPath);
+    bool runStreamingQueryTest(const std::string& aPath);
 
     class StringIterator {
     public:
@@ -52,18 +48,72 @@ namespace JSONProc {
 
     class CommandProcessor {
     public:
-        CommandProcessor(Model& aModel);
+        enum class CommandType { select = 0, filter, count, sum, get, min, max, avg, invalid };
+
+        // One command of a query, with its parameter decoded ahead of time
+        struct Command {
+            CommandType type;
+            std::string parameter;
+            QueryPath path; // select and get, except get(*)
+            filterPolicy filter; // filter
+        };
+
+        // A whole query compiled once, so running it again skips the lexing and path parsing
+        struct Plan {
+            std::vector<Command> commands;
+            bool isValid = true;
+        };
+
+        using PlanCache = LRUCache<std::string, std::shared_ptr<const Plan>>;
+        static constexpr size_t kDefaultCacheSize = 256;
+
+        // Processors that share aCache share their compiled queries; without one, each has its own
+        CommandProcessor(Model& aModel, std::shared_ptr<PlanCache> aCache = nullptr);
 
         std::optional<std::string> process(const std::string& aQuery);
 
+        // Answers aQueries with one walk of the Model, looking up a select path prefix that
+        // several share once; each answer is what process() gives for that query alone
+        std::vector<std::optional<std::string>> processBatch(const std::vector<std::string>& aQueries);
+
+        // Answers aQuery from the document aSource reads. A select without * or .. steps and then
+        // one consumer, with no filter, is answered from the parser's events as a StreamingQuery,
+        // which stops reading once the answer is final; other queries parse a whole Model first.
+        static std::optional<std::string> processStream(const std::string& aQuery, InputSource& aSource);
+
+        const PlanCache& getCache() const { return *cache; }
+
     protected:
-        std::array<std::string, 5> commandList { "select", "filter", "count", "sum", "get" };
-        enum class CommandType { select = 0, filter, count, sum, get, invalid };
+        static inline const std::array<std::string, 8> commandList { "select", "filter", "count", "sum", "get", "min", "max", "avg" };
 
-        CommandType getCommandType(StringIterator& anIterator);
-        std::optional<std::string> callCommand(CommandType aType, const std::string& aParameter);
+        static CommandType getCommandType(StringIterator& anIterator);
+        std::shared_ptr<const Plan> getPlan(const std::string& aQuery); // from the cache, or compiled
+        static std::shared_ptr<const Plan> compile(const std::string& aQuery);
+        std::optional<std::string> callCommand(const Command& aCommand);
 
         ModelQuery modelQuery;
+        std::shared_ptr<PlanCache> cache;
+
+    };
+
+    class Autograder {
+    public:
+        Autograder(const std::string& aWorkingDirectoryPath, ModelMode aMode = ModelMode::eager);
+
+        bool runTest(const std::string& aTestName);
+
+    protected:
+        bool openFiles(const std::string& aTestName);
+        bool parseJson(Model& aModel);
+
+        bool runCommands(Model& aModel);
+
+        std::string getExpectedOutput(const std::string& aQuery);
+
+        std::string workingDirectory;
+        std::fstream testFile, jsonFile;
+        ModelMode mode;
+        std::shared_ptr<CommandProcessor::PlanCache> planCache; // shared by every line of a test
 
     };
 
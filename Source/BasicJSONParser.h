@@ -0,0 +1,625 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include "InputSource.h"
+#include "JSONListener.h"
+#include "Projection.h"
+#include "StructuralIndex.h"
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stack>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace JSONProc {
+
+	// ---Basic Parsing Utilities---
+
+	const char kColon = ':';
+	const char kComma = ',';
+	const char kQuote = '"';
+	const char kBackslash = '\\';
+	const char kBraceOpen = '{';
+	const char kBraceClose = '}';
+	const char kBracketOpen = '[';
+	const char kBracketClose = ']';
+
+	// Set of characters, looked up by table instead of strchr
+	class CharClass {
+	public:
+		constexpr CharClass(const char *aChars, size_t aLength) : members{} {
+			for (size_t i = 0; i < aLength; ++i)
+				members[static_cast<unsigned char>(aChars[i])] = true;
+		}
+
+		constexpr bool operator()(char aChar) const { return members[static_cast<unsigned char>(aChar)]; }
+
+	protected:
+		bool members[256];
+	};
+
+	// The old strchr lookup also matched the terminating '\0'
+	constexpr CharClass kWhitespace(" \t\r\n\b\xff", 7);
+	constexpr CharClass kConstantChars(
+		"0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ.+-", 65);
+
+	// Where a skipped container's brackets and strings could start or end
+	constexpr CharClass kSkipStops("\"\\{}[]", 6);
+
+	inline const char *skipWhile(const char *aCursor, const char *anEnd, const CharClass &aClass) {
+		while (aCursor != anEnd && aClass(*aCursor))
+			++aCursor;
+		return aCursor;
+	}
+
+	// Back over the whitespace and commas the parser read past after an element, to where it
+	// ended; no element ends in either
+	inline const char *skipBackSeparators(const char *aCursor, const char *aStart) {
+		while (aCursor != aStart && (kWhitespace(aCursor[-1]) || kComma == aCursor[-1]))
+			--aCursor;
+		return aCursor;
+	}
+
+	inline bool skipIfChar(const char *&aCursor, const char *anEnd, char aChar) {
+		const bool isMatch = aCursor != anEnd && aChar == *aCursor;
+		if (isMatch)
+			++aCursor;
+		return isMatch;
+	}
+
+	// Closing quote of a string, stepping over escaped quotes; anEnd if it isn't buffered yet
+	inline const char *findClosingQuote(const char *aCursor, const char *anEnd) {
+		const char *theStart = aCursor;
+		while (const void *theMatch = memchr(aCursor, kQuote, static_cast<size_t>(anEnd - aCursor))) {
+			const char *theQuote = static_cast<const char*>(theMatch);
+			const char *theEscapes = theQuote;
+			while (theEscapes != theStart && kBackslash == theEscapes[-1])
+				--theEscapes;
+
+			if (0 == (theQuote - theEscapes) % 2)
+				return theQuote;
+			aCursor = theQuote + 1;
+		}
+		return anEnd;
+	}
+
+	inline bool hasEscapes(std::string_view aString) {
+		return memchr(aString.data(), kBackslash, aString.size()) != nullptr;
+	}
+
+	inline Element determineType(char aChar) {
+		const char *kConstantChars = "01234567890-tfn";
+		switch (aChar) {
+			case kQuote:
+				return Element::quoted;
+			case kBraceOpen:
+				return Element::object;
+			case kBracketOpen:
+				return Element::array;
+			case kBraceClose:
+			case kBracketClose:
+				return Element::closing;
+			default:
+				return strchr(kConstantChars, aChar) ? Element::constant : Element::unknown;
+		}
+	}
+
+
+	//--------------------------------------------
+	// Used for parsing to keep track of state
+	struct JSONState {
+		JSONState(std::string_view aKey, Element aType = Element::object, const Projection *aProjection = nullptr)
+			: key(aKey), type(aType), projection(aProjection) {}
+
+		JSONState(const JSONState &aCopy)
+			: key(aCopy.key), type(aCopy.type), projection(aCopy.projection), count(aCopy.count) {}
+
+		std::string key;
+		Element type;
+		const Projection *projection; // what to keep of the elements; nullptr keeps them all
+		size_t count = 0;             // items so far, in a list
+	};
+
+	// streaming walks the input character by character; indexed first builds a
+	// StructuralIndex of the whole document and then walks its offsets
+	enum class ParseMode {
+		streaming, indexed
+	};
+
+	//--------------------------------------------
+	// The parser, compiled for one listener type. Events go straight to Listener's callbacks,
+	// so when Listener is a final class (like Model or NullListener) they aren't virtual calls
+	// and can be inlined. JSONParser is the version for any JSONViewListener.
+	template <typename Listener>
+	class BasicJSONParser {
+		friend class ParallelParser;
+
+	public:
+		BasicJSONParser(std::istream &anInputStream, ParseMode aMode = ParseMode::streaming)
+			: ownedSource(std::make_unique<StreamSource>(anInputStream)), source(ownedSource.get()), mode(aMode) {}
+		BasicJSONParser(InputSource &aSource, ParseMode aMode = ParseMode::streaming) : source(&aSource), mode(aMode) {}
+
+		bool parse(Listener *aListener);
+
+		// Only build the parts of the document that aProjection selects (it must outlive the parse)
+		void setProjection(const Projection *aProjection) { projection = aProjection; }
+
+		// The listener ended the parse early, once it was done (see JSONViewListener::isDone)
+		bool wasStopped() const { return isStopped; }
+		// How far into the input the parse got: all of it, unless the listener stopped it
+		size_t getBytesConsumed() const { return consumed; }
+
+	protected:
+		// Outcome of parsing one element from the buffered input
+		enum class Progress { parsed, incomplete, failed };
+
+		BasicJSONParser() : source(nullptr), mode(ParseMode::streaming) {} // input is pushed by JSONPushParser
+
+		bool willParse(Listener *aListener);
+		bool didParse(bool aStatus);
+
+		bool consume(std::string_view aBlock, bool isLast, Listener *aListener);
+		bool parseFragment(std::string_view aFragment, Element aType, Listener *aListener);
+		bool parseIndexed(std::string_view aDocument, Listener *aListener);
+
+		Progress parseElements(Listener *aListener);
+		Progress parseString(const char *aClosingQuote, Listener *aListener);
+		Progress parseConstant(Listener *aListener);
+		bool addConstant(std::string_view aKey, std::string_view aText, Listener *aListener);
+		bool addString(std::string_view aValue, Listener *aListener);
+
+		const Projection* projectElement();
+		bool addPlaceholder(Listener *aListener);
+		bool skipContainer();
+
+		bool handleOpenContainer(Element aType, Listener *aListener, const Projection *aProjection = nullptr);
+		bool handleCloseContainer(Element aType, Listener *aListener);
+
+		std::stack<JSONState, std::vector<JSONState>> states; // vector-backed: no deque block per parser
+		std::string_view tempKey;  // points into the input...
+		std::string keyBuffer;     // ...or here, once the block it came from is gone
+
+		std::unique_ptr<InputSource> ownedSource; // stream adapter, when built from an istream
+		InputSource *source;
+		ParseMode mode;
+		bool deliversText = false; // constants go to a JSONListener as they were written
+		std::string document; // indexed mode's copy of a source that isn't contiguous
+
+		// Window of input currently being parsed
+		const char *cursor = nullptr;
+		const char *end = nullptr;
+		bool atLastBlock = false;
+		bool hasStarted = false;
+		bool isRejected = false;
+		bool isStopped = false; // the listener is done, so the rest of the input goes unread
+		std::string pending; // unparsed tail carried over to the next block
+		size_t received = 0; // input handed to consume() so far
+		size_t consumed = 0;
+
+		// A container the projection leaves out is stepped over, across blocks if need be
+		const Projection *projection = nullptr;
+		size_t skipDepth = 0;
+		bool isSkippingString = false;
+		bool isSkippingEscape = false;
+	};
+
+
+	// ---BasicJSONParser---
+
+	template <typename Listener>
+	bool BasicJSONParser<Listener>::parse(Listener *aListener) {
+		if (ParseMode::indexed == mode) {
+			std::string_view theDocument = source->nextBlock();
+			if (!source->isContiguous()) {
+				document.assign(theDocument);
+				for (auto theBlock = source->nextBlock(); !theBlock.empty(); theBlock = source->nextBlock())
+					document.append(theBlock);
+				theDocument = document;
+			}
+			return didParse(parseIndexed(theDocument, aListener));
+		}
+
+		bool isValid = true;
+		std::string_view theBlock;
+		do {
+			theBlock = source->nextBlock();
+			isValid = consume(theBlock, theBlock.empty(), aListener);
+		} while (isValid && !isStopped && !theBlock.empty());
+
+		return didParse(isValid);
+	}
+
+	template <typename Listener>
+	bool BasicJSONParser<Listener>::didParse(bool aState) {
+		return aState;
+	}
+
+	// The root is an object or, as in JSON Lines records, a list
+	template <typename Listener>
+	bool BasicJSONParser<Listener>::willParse(Listener *aListener) {
+		if (skipIfChar(cursor, end, kBraceOpen)) {
+			return handleOpenContainer(Element::object, aListener, projection); // Open default container...
+		}
+		if (skipIfChar(cursor, end, kBracketOpen)) {
+			return handleOpenContainer(Element::array, aListener, projection);
+		}
+		return false;
+	}
+
+	// Parses every complete element in the block; an element cut off by the end
+	// of the block is carried over and finished when the next block arrives
+	template <typename Listener>
+	bool BasicJSONParser<Listener>::consume(std::string_view aBlock, bool isLast, Listener *aListener) {
+		if (isStopped)
+			return true;
+		received += aBlock.size();
+		const bool isCarryingOver = !pending.empty();
+		if (isCarryingOver) {
+			pending.append(aBlock);
+			aBlock = pending;
+		}
+		cursor = aBlock.data();
+		end = cursor + aBlock.size();
+		atLastBlock = isLast;
+
+		bool isValid = true;
+		if (!hasStarted) {
+			cursor = skipWhile(cursor, end, kWhitespace);
+			if (cursor != end || isLast) {
+				hasStarted = true;
+				isRejected = !willParse(aListener);
+			}
+		}
+
+		while (isValid && hasStarted && !isRejected) {
+			if (skipDepth && !skipContainer())
+				break;
+			cursor = skipWhile(cursor, end, kWhitespace);
+			if (cursor == end)
+				break;
+
+			const char *theStart = cursor;
+			const Progress theProgress = parseElements(aListener);
+			if (Progress::incomplete == theProgress) {
+				cursor = theStart;
+				break;
+			}
+			isValid = Progress::parsed == theProgress;
+		}
+
+		// A listener that is done refuses events to stop the parse, which isn't a failure
+		if ((isRejected || !isValid) && aListener->isDone()) {
+			isStopped = true;
+			isRejected = false;
+			isValid = true;
+			cursor = skipBackSeparators(cursor, aBlock.data());
+		}
+		consumed = received - static_cast<size_t>(end - cursor);
+
+		if (isRejected) {
+			cursor = end;
+			isValid = false;
+		}
+		else if (isStopped) {
+			pending.clear(); // nothing more will be parsed
+			return true;
+		}
+		else if (isLast && !states.empty())
+			isValid = false; // The input ended inside a container
+
+		// A key waiting for its value can't point into a block we're about to drop
+		if (!tempKey.empty() && tempKey.data() != keyBuffer.data()) {
+			keyBuffer.assign(tempKey);
+			tempKey = keyBuffer;
+		}
+
+		if (isCarryingOver)
+			pending.erase(0, static_cast<size_t>(cursor - pending.data()));
+		else
+			pending.assign(cursor, end);
+		return isValid;
+	}
+
+	// Parses some of a container's elements, without its brackets, as if they were a whole
+	// container of aType. ParallelParser splits a large container into fragments like this.
+	template <typename Listener>
+	bool BasicJSONParser<Listener>::parseFragment(std::string_view aFragment, Element aType, Listener *aListener) {
+		cursor = aFragment.data();
+		end = cursor + aFragment.size();
+		atLastBlock = hasStarted = true;
+		if (!handleOpenContainer(aType, aListener))
+			return false;
+
+		while ((cursor = skipWhile(cursor, end, kWhitespace)) != end) {
+			if (Progress::parsed != parseElements(aListener))
+				return false;
+		}
+		return 1 == states.size() && handleCloseContainer(aType, aListener);
+	}
+
+	// Second stage of the indexed mode: jump from one structural offset to the next
+	// instead of walking the whitespace and string contents in between. For valid JSON
+	// this produces the same events as the streaming mode.
+	template <typename Listener>
+	bool BasicJSONParser<Listener>::parseIndexed(std::string_view aDocument, Listener *aListener) {
+		StructuralIndex theIndex;
+		if (!theIndex.build(aDocument)) {
+			BufferSource theSource(aDocument); // Too large to index
+			return consume(theSource.nextBlock(), false, aListener) && consume({}, true, aListener);
+		}
+
+		const char *theBase = aDocument.data();
+		cursor = skipWhile(theBase, theBase + aDocument.size(), kWhitespace);
+		end = theBase + aDocument.size();
+		atLastBlock = hasStarted = true;
+		consumed = aDocument.size();
+		if (!willParse(aListener)) {
+			isStopped = aListener->isDone();
+			if (isStopped) // at the root's opening, so only that much was read
+				consumed = static_cast<size_t>(skipBackSeparators(cursor, theBase) - theBase);
+			return isStopped;
+		}
+
+		bool theResult = true;
+		const size_t theCount = theIndex.size();
+		for (size_t i = 0; theResult && i < theCount; ++i) {
+			const char *thePosition = theBase + theIndex[i];
+			if (thePosition < cursor)
+				continue; // Consumed along with the previous element
+			if (states.empty())
+				return false; // Content after the root container closed
+
+			cursor = thePosition + 1;
+			switch (*thePosition) {
+				case kQuote: {
+					const char *theClosingQuote = i + 1 < theCount ? theBase + theIndex[++i] : end;
+					const char *theNext = i + 1 < theCount ? theBase + theIndex[i + 1] : end;
+					const std::string_view theValue(cursor, static_cast<size_t>(theClosingQuote - cursor));
+					if (Element::object == states.top().type && theNext != end && kColon == *theNext) {
+						tempKey = theValue;
+						++i;
+					}
+					else
+						theResult = addString(theValue, aListener);
+					cursor = theClosingQuote + 1;
+					break;
+				}
+
+				case kBraceOpen:
+				case kBracketOpen:
+				case kBraceClose:
+				case kBracketClose:
+					--cursor;
+					theResult = Progress::parsed == parseElements(aListener);
+					break;
+
+				case kComma:
+				case kColon:
+					break;
+
+				default: {
+					// A run of constant characters; walk it the way the streaming mode does
+					const char *theRunEnd = i + 1 < theCount ? theBase + theIndex[i + 1] : end;
+					for (--cursor; theResult && (cursor = skipWhile(cursor, theRunEnd, kWhitespace)) < theRunEnd; )
+						theResult = Progress::parsed == parseElements(aListener);
+				}
+			}
+		}
+
+		if (!theResult && aListener->isDone()) {
+			isStopped = true;
+			consumed = static_cast<size_t>(skipBackSeparators(cursor, theBase) - theBase);
+			return true;
+		}
+		return theResult && states.empty();
+	}
+
+
+	template <typename Listener>
+	bool BasicJSONParser<Listener>::handleOpenContainer(Element aType, Listener *aListener, const Projection *aProjection) {
+		if (!states.empty() && Element::array == states.top().type)
+			++states.top().count;
+		states.emplace(tempKey, aType, aProjection && !aProjection->isSelected() ? aProjection : nullptr);
+		tempKey = {};
+		return aListener->openContainer(states.top().key, aType);
+	}
+
+	template <typename Listener>
+	bool BasicJSONParser<Listener>::handleCloseContainer(Element aType, Listener *aListener) {
+		tempKey = {};
+		const std::string theKey(std::move(states.top().key));
+		if (!states.empty())
+			states.pop();
+
+		return aListener->closeContainer(theKey, aType);
+	}
+
+
+	// Parse the element starting at the cursor
+	template <typename Listener>
+	typename BasicJSONParser<Listener>::Progress BasicJSONParser<Listener>::parseElements(Listener *aListener) {
+		if (states.empty())
+			return Progress::failed; // Content after the root container closed
+
+		bool theResult = true;
+
+		const char theChar = *cursor++;
+		const Element theType = determineType(theChar);
+		const JSONState &theTop = states.top();
+
+		switch (theType) {
+			case Element::object:
+			case Element::array:
+				if (const Projection *theProjection = projectElement())
+					theResult = handleOpenContainer(theType, aListener, theProjection);
+				else {
+					theResult = addPlaceholder(aListener);
+					skipDepth = 1;
+					skipContainer(); // Finishes in a later block if this one ends first
+				}
+				break;
+
+			case Element::closing:
+				theResult = handleCloseContainer(theTop.type, aListener);
+				cursor = skipWhile(cursor, end, kWhitespace);
+				skipIfChar(cursor, end, kComma);
+				break;
+
+			case Element::quoted:
+				return parseString(findClosingQuote(cursor, end), aListener);
+
+			case Element::constant:
+				return parseConstant(aListener);
+
+			default:
+				// Separators are stepped over (a block may end right before one), as the indexed
+				// mode does, but no value starts with anything else, such as the + of +1
+				return kComma == theChar || kColon == theChar ? Progress::parsed : Progress::failed;
+		}
+
+		return theResult ? Progress::parsed : Progress::failed;
+	}
+
+	// Cursor is just past the opening quote
+	template <typename Listener>
+	typename BasicJSONParser<Listener>::Progress BasicJSONParser<Listener>::parseString(const char *aClosingQuote, Listener *aListener) {
+		const JSONState &theTop = states.top();
+		const char *theNext = aClosingQuote;
+		skipIfChar(theNext, end, kQuote);
+		theNext = skipWhile(theNext, end, kWhitespace);
+		skipIfChar(theNext, end, kComma);
+
+		// A key is only known once we've seen the colon that follows it
+		if (!atLastBlock && (aClosingQuote == end || (theNext == end && Element::object == theTop.type)))
+			return Progress::incomplete;
+
+		const std::string_view theValue(cursor, static_cast<size_t>(aClosingQuote - cursor));
+		cursor = theNext;
+
+		bool theResult = true;
+		if (Element::object == theTop.type && skipIfChar(cursor, end, kColon))
+			tempKey = theValue;
+		else
+			theResult = addString(theValue, aListener);
+
+		return theResult ? Progress::parsed : Progress::failed;
+	}
+
+	template <typename Listener>
+	bool BasicJSONParser<Listener>::addString(std::string_view aValue, Listener *aListener) {
+		JSONState &theTop = states.top();
+		if (!projectElement())
+			return addPlaceholder(aListener);
+
+		if (Element::object == theTop.type)
+			return aListener->addKeyValuePair(tempKey, aValue, Element::quoted, hasEscapes(aValue));
+		++theTop.count;
+		return aListener->addItem(aValue, Element::quoted, hasEscapes(aValue));
+	}
+
+	// Cursor is just past the constant's first character
+	template <typename Listener>
+	typename BasicJSONParser<Listener>::Progress BasicJSONParser<Listener>::parseConstant(Listener *aListener) {
+		const char *theEnd = skipWhile(cursor, end, kConstantChars);
+		if (theEnd == end && !atLastBlock)
+			return Progress::incomplete;
+
+		const std::string_view theValue(cursor - 1, static_cast<size_t>(theEnd - cursor + 1));
+		cursor = skipWhile(theEnd, end, kWhitespace);
+		skipIfChar(cursor, end, kComma);
+
+		bool theResult = true;
+		const bool isInObject = Element::object == states.top().type;
+		if (!projectElement())
+			return addPlaceholder(aListener) ? Progress::parsed : Progress::failed;
+		if (!isInObject)
+			++states.top().count;
+
+		if (!deliversText)
+			theResult = addConstant(isInObject ? tempKey : std::string_view(), theValue, aListener);
+		else if (JSONConstant::Kind::invalid == JSONConstant::parse(theValue).kind)
+			theResult = false; // Text goes out as written, but only once it's a valid constant
+		else if (isInObject)
+			theResult = aListener->addKeyValuePair(tempKey, theValue, Element::constant, false);
+		else
+			theResult = aListener->addItem(theValue, Element::constant, false);
+
+		return theResult ? Progress::parsed : Progress::failed;
+	}
+
+	template <typename Listener>
+	bool BasicJSONParser<Listener>::addConstant(std::string_view aKey, std::string_view aText, Listener *aListener) {
+		const JSONConstant theConstant = JSONConstant::parse(aText);
+		switch (theConstant.kind) {
+			case JSONConstant::Kind::integer:
+				return aListener->addInteger(aKey, theConstant.integer);
+			case JSONConstant::Kind::real:
+				return aListener->addDouble(aKey, theConstant.real);
+			case JSONConstant::Kind::boolean:
+				return aListener->addBool(aKey, theConstant.boolean);
+			case JSONConstant::Kind::null:
+				return aListener->addNull(aKey);
+			default:
+				return false; // Not a number, true, false or null
+		}
+	}
+
+	// What the projection keeps of the element about to go into the top container;
+	// nullptr when it's left out
+	template <typename Listener>
+	const Projection* BasicJSONParser<Listener>::projectElement() {
+		const JSONState &theTop = states.top();
+		if (!theTop.projection)
+			return &Projection::getEverything();
+		return Element::object == theTop.type ? theTop.projection->find(tempKey) : theTop.projection->find(theTop.count);
+	}
+
+	// A list item that was left out becomes a null, so the items after it keep their indices
+	template <typename Listener>
+	bool BasicJSONParser<Listener>::addPlaceholder(Listener *aListener) {
+		if (Element::object == states.top().type)
+			return true;
+		++states.top().count;
+		return deliversText ? aListener->addItem("null", Element::constant, false) : aListener->addNull({});
+	}
+
+	// Steps over the rest of a left out container by matching brackets outside of strings.
+	// False when the block ends first; the scan picks up where it stopped in the next one.
+	template <typename Listener>
+	bool BasicJSONParser<Listener>::skipContainer() {
+		while (skipDepth) {
+			while (cursor != end && !kSkipStops(*cursor) && !isSkippingEscape)
+				++cursor;
+			if (cursor == end)
+				return false;
+
+			const char theChar = *cursor++;
+			if (isSkippingString) {
+				if (isSkippingEscape)
+					isSkippingEscape = false;
+				else if (kBackslash == theChar)
+					isSkippingEscape = true;
+				else if (kQuote == theChar)
+					isSkippingString = false;
+			}
+			else if (kQuote == theChar)
+				isSkippingString = true;
+			else if (kBraceOpen == theChar || kBracketOpen == theChar)
+				++skipDepth;
+			else if (kBraceClose == theChar || kBracketClose == theChar)
+				--skipDepth;
+		}
+
+		cursor = skipWhile(cursor, end, kWhitespace);
+		skipIfChar(cursor, end, kComma);
+		return true;
+	}
+
+	extern template class BasicJSONParser<JSONViewListener>;
+
+}
@@ -0,0 +1,455 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "Benchmark.h"
+
+#include "Autograder.h"
+#include "JSONParser.h"
+#include "InputSource.h"
+#include "JSONLines.h"
+#include "Model.h"
+#include "ParallelParser.h"
+#include "Projection.h"
+#include "StructuralIndex.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace JSONProc {
+
+    size_t getBenchmarkSize() {
+        const char *theSetting = std::getenv("JSONPROC_BENCH_MB");
+        const long theMegabytes = theSetting ? std::atol(theSetting) : 0;
+        return static_cast<size_t>(theMegabytes > 0 ? theMegabytes : 64) * 1024 * 1024;
+    }
+
+    // Array of small records shaped like the ones in Resources/, about aSize bytes long
+    std::string generateDocument(size_t aSize) {
+        std::string theDocument = "{\n  \"records\": [\n";
+        theDocument.reserve(aSize + 256);
+
+        char theRecord[256];
+        for (size_t i = 0; theDocument.size() < aSize; ++i) {
+            const int theLength = std::snprintf(theRecord, sizeof(theRecord),
+                "    {\"id\": %zu, \"name\": \"user_%zu\", \"active\": %s, \"score\": %zu.%zu, "
+                "\"tags\": [\"alpha\", \"beta\"], \"parent\": null},\n",
+                i, i, (i % 3) ? "true" : "false", i % 100, i % 10);
+            theDocument.append(theRecord, static_cast<size_t>(theLength));
+        }
+
+        theDocument.erase(theDocument.size() - 2); // trailing ",\n"
+        theDocument += "\n  ]\n}\n";
+        return theDocument;
+    }
+
+    // Rows of readings, nearly all numbers
+    std::string generateNumericDocument(size_t aSize) {
+        std::string theDocument = "{\"readings\": [\n";
+        theDocument.reserve(aSize + 256);
+
+        char theRow[256];
+        for (size_t i = 0; theDocument.size() < aSize; ++i) {
+            const int theLength = std::snprintf(theRow, sizeof(theRow),
+                "[%zu, -%zu, %zu.%03zu, %zue-%zu, %zu.0],\n",
+                i, i * 7 % 100000, i % 1000, i * 13 % 1000, i % 97 + 1, i % 9, i % 50);
+            theDocument.append(theRow, static_cast<size_t>(theLength));
+        }
+
+        theDocument.erase(theDocument.size() - 2);
+        theDocument += "\n]}\n";
+        return theDocument;
+    }
+
+    // One small record per line
+    std::string generateLines(size_t aSize) {
+        std::string theDocument;
+        theDocument.reserve(aSize + 256);
+
+        char theRecord[256];
+        for (size_t i = 0; theDocument.size() < aSize; ++i) {
+            const int theLength = std::snprintf(theRecord, sizeof(theRecord),
+                "{\"id\": %zu, \"level\": \"%s\", \"message\": \"request %zu served\", \"ms\": %zu.%zu}\n",
+                i, (i % 5) ? "info" : "warn", i, i % 400, i % 10);
+            theDocument.append(theRecord, static_cast<size_t>(theLength));
+        }
+        return theDocument;
+    }
+
+    // Counts values without keeping anything, like a validation pass would
+    class CountingListener : public JSONViewListener {
+    public:
+        bool addKeyValuePair(std::string_view, std::string_view, Element, bool) override { return ++count; }
+        bool addItem(std::string_view, Element, bool) override { return ++count; }
+        bool openContainer(std::string_view, Element) override { return ++count; }
+        bool closeContainer(std::string_view, Element) override { return true; }
+        bool addInteger(std::string_view, std::int64_t) override { return ++count; }
+        bool addDouble(std::string_view, double) override { return ++count; }
+        bool addBool(std::string_view, bool) override { return ++count; }
+        bool addNull(std::string_view) override { return ++count; }
+
+        size_t count = 0;
+    };
+
+    // Visits every node, as a full scan of the Model would
+    size_t countNodes(const ModelNode &aNode) {
+        size_t theCount = 1;
+        if (ModelNode::Type::list == aNode.getType()) {
+            for (size_t i = 0; i < aNode.size(); ++i)
+                theCount += countNodes(aNode.getItems()[i]);
+        }
+        else if (ModelNode::Type::object == aNode.getType()) {
+            for (size_t i = 0; i < aNode.size(); ++i)
+                theCount += countNodes(aNode.getMembers()[i].value);
+        }
+        return theCount;
+    }
+
+    // Runs aParse a few times and prints the best throughput
+    void reportThroughput(const std::string& aLabel, size_t aSize, const std::function<bool()>& aParse) {
+        const int kRepetitions = 3;
+        double theBest = 0;
+        bool isValid = true;
+        for (int i = 0; i < kRepetitions; ++i) {
+            const auto theStart = std::chrono::steady_clock::now();
+            isValid = aParse() && isValid;
+            const std::chrono::duration<double> theElapsed = std::chrono::steady_clock::now() - theStart;
+            if (theBest == 0 || theElapsed.count() < theBest)
+                theBest = theElapsed.count();
+        }
+
+        const double theMegabytes = static_cast<double>(aSize) / (1024 * 1024);
+        std::cout << std::left << std::setw(28) << aLabel << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << theMegabytes / theBest << " MB/s"
+                  << (isValid ? "" : "  (parse failed)") << "\n";
+    }
+
+    // Runs aCount operations a few times and prints the best rate
+    void reportRate(const std::string& aLabel, size_t aCount, const std::string& aUnit, const std::function<bool()>& aRun) {
+        double theBest = 0;
+        bool isValid = true;
+        for (int i = 0; i < 3; ++i) {
+            const auto theStart = std::chrono::steady_clock::now();
+            isValid = aRun() && isValid;
+            const std::chrono::duration<double> theElapsed = std::chrono::steady_clock::now() - theStart;
+            if (theBest == 0 || theElapsed.count() < theBest)
+                theBest = theElapsed.count();
+        }
+
+        std::cout << std::left << std::setw(28) << aLabel << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << static_cast<double>(aCount) / theBest / 1e6 << " M " << aUnit << "/s"
+                  << (isValid ? "" : "  (failed)") << "\n";
+    }
+
+    bool runParserBenchmark([[maybe_unused]] const std::string& aPath) {
+        const std::string theDocument = generateDocument(getBenchmarkSize());
+        const auto theFilePath = std::filesystem::temp_directory_path() / "jsonproc_benchmark.json";
+        {
+            std::ofstream theFile(theFilePath, std::ios::binary);
+            theFile << theDocument;
+        }
+
+        std::cout << "Parsing " << theDocument.size() / (1024 * 1024) << " MB\n";
+
+        reportThroughput("std::istream (ifstream)", theDocument.size(), [&]() {
+            std::ifstream theFile(theFilePath, std::ios::binary);
+            JSONParser theParser(theFile);
+            return theParser.parse();
+        });
+
+        reportThroughput("StreamSource (4 KB blocks)", theDocument.size(), [&]() {
+            std::ifstream theFile(theFilePath, std::ios::binary);
+            StreamSource theSource(theFile, 4096);
+            JSONParser theParser(theSource);
+            return theParser.parse();
+        });
+
+        reportThroughput("BufferSource", theDocument.size(), [&]() {
+            BufferSource theSource(theDocument);
+            JSONParser theParser(theSource);
+            return theParser.parse();
+        });
+
+        reportThroughput("MappedFileSource", theDocument.size(), [&]() {
+            MappedFileSource theSource(theFilePath.string());
+            JSONParser theParser(theSource);
+            return theSource.isOpen() && theParser.parse();
+        });
+
+        reportThroughput("BufferSource, indexed", theDocument.size(), [&]() {
+            BufferSource theSource(theDocument);
+            JSONParser theParser(theSource, ParseMode::indexed);
+            return theParser.parse();
+        });
+
+        reportThroughput("MappedFileSource, indexed", theDocument.size(), [&]() {
+            MappedFileSource theSource(theFilePath.string());
+            JSONParser theParser(theSource, ParseMode::indexed);
+            return theSource.isOpen() && theParser.parse();
+        });
+
+        reportThroughput("Null listener, virtual", theDocument.size(), [&]() {
+            NullListener theListener;
+            BufferSource theSource(theDocument);
+            return JSONParser(theSource).parse(static_cast<JSONViewListener*>(&theListener));
+        });
+
+        reportThroughput("Null listener, template", theDocument.size(), [&]() {
+            NullListener theListener;
+            BufferSource theSource(theDocument);
+            return BasicJSONParser<NullListener>(theSource).parse(&theListener);
+        });
+
+        reportThroughput("Counting listener", theDocument.size(), [&]() {
+            CountingListener theListener;
+            BufferSource theSource(theDocument);
+            return JSONParser(theSource).parse(&theListener);
+        });
+
+        reportThroughput("Counting listener, indexed", theDocument.size(), [&]() {
+            CountingListener theListener;
+            BufferSource theSource(theDocument);
+            return JSONParser(theSource, ParseMode::indexed).parse(&theListener);
+        });
+
+        // Models are several times the size of their document, so they get a smaller one
+        const std::string theNumbers = generateNumericDocument(theDocument.size() / 8);
+        reportThroughput("Model, numeric", theNumbers.size(), [&]() {
+            Model theModel;
+            BufferSource theSource(theNumbers);
+            return JSONParser(theSource).parse(&theModel);
+        });
+
+        const std::string theRecords = generateDocument(theDocument.size() / 8);
+        reportThroughput("Model, virtual", theRecords.size(), [&]() {
+            Model theModel;
+            BufferSource theSource(theRecords);
+            return JSONParser(theSource).parse(&theModel);
+        });
+        reportThroughput("Model, template", theRecords.size(), [&]() {
+            Model theModel;
+            BufferSource theSource(theRecords);
+            return BasicJSONParser<Model>(theSource).parse(&theModel);
+        });
+        {
+            Model theModel;
+            BufferSource theSource(theRecords);
+            JSONParser(theSource).parse(&theModel);
+            const size_t theNodes = countNodes(theModel.getRoot());
+            const Arena &theArena = theModel.getArena();
+            std::cout << std::left << std::setw(28) << "Model memory" << std::right << std::fixed << std::setprecision(1)
+                      << std::setw(10) << static_cast<double>(theArena.getUsed()) / theNodes << " bytes/node, "
+                      << static_cast<double>(theArena.getReserved()) / theRecords.size() << "x the input\n";
+            reportThroughput("Model, traversal", theRecords.size(), [&]() {
+                return countNodes(theModel.getRoot()) == theNodes;
+            });
+            const size_t kQueries = 100000;
+            reportRate("Query, string path", kQueries, "queries", [&]() {
+                size_t theCount = 0;
+                for (size_t i = 0; i < kQueries; ++i)
+                    theCount += theModel.createQuery().select("'records'.1000.'tags'").count();
+                return theCount == kQueries * 2;
+            });
+            const QueryPath thePath("'records'.1000.'tags'");
+            reportRate("Query, compiled path", kQueries, "queries", [&]() {
+                size_t theCount = 0;
+                for (size_t i = 0; i < kQueries; ++i)
+                    theCount += theModel.createQuery().select(thePath).count();
+                return theCount == kQueries * 2;
+            });
+            // Every record's tags: a query per record, against one set-valued path
+            const size_t theRecordCount = theModel.getRoot().find("records")->size();
+            size_t theTagCount = 0;
+            reportRate("Tags, query per record", theRecordCount, "records", [&]() {
+                theTagCount = 0;
+                for (size_t i = 0; i < theRecordCount; ++i)
+                    theTagCount += theModel.createQuery().select(QueryPath("'records'." + std::to_string(i) + ".'tags'")).count();
+                return theTagCount > 0;
+            });
+            reportRate("Tags, one * path", theRecordCount, "records", [&]() {
+                return theModel.createQuery().select("'records'.*.'tags'.*").count() == theTagCount;
+            });
+            const std::string theCommand = "select('records'.1000.'tags').filter(index > 0).count()";
+            reportRate("Commands, compiled each time", kQueries, "queries", [&]() {
+                size_t theCount = 0;
+                for (size_t i = 0; i < kQueries; ++i)
+                    theCount += CommandProcessor(theModel).process(theCommand) == "1";
+                return theCount == kQueries;
+            });
+            const auto theCache = std::make_shared<CommandProcessor::PlanCache>(CommandProcessor::kDefaultCacheSize);
+            reportRate("Commands, cached plans", kQueries, "queries", [&]() {
+                size_t theCount = 0;
+                for (size_t i = 0; i < kQueries; ++i)
+                    theCount += CommandProcessor(theModel, theCache).process(theCommand) == "1";
+                return theCount == kQueries;
+            });
+            std::cout << std::left << std::setw(28) << "Plan cache" << std::right << std::setw(10)
+                      << theCache->getHits() << " hits, " << theCache->getMisses() << " misses\n";
+
+            // 42 fields of seven neighbouring records, as one request would ask for them
+            std::vector<std::string> theFields;
+            for (size_t i = 1000; i < 1007; ++i)
+                for (const auto *theField : {"id", "name", "active", "score", "tags", "parent"})
+                    theFields.push_back("select('records'." + std::to_string(i) + ").get('" + theField + "')");
+            const size_t kRequests = 5000;
+            reportRate("Fields, one query each", kRequests * theFields.size(), "queries", [&]() {
+                CommandProcessor theProcessor(theModel, theCache);
+                size_t theCount = 0;
+                for (size_t i = 0; i < kRequests; ++i)
+                    for (const auto &theField : theFields)
+                        theCount += theProcessor.process(theField).has_value();
+                return theCount == kRequests * theFields.size();
+            });
+            reportRate("Fields, one batch", kRequests * theFields.size(), "queries", [&]() {
+                CommandProcessor theProcessor(theModel, theCache);
+                size_t theCount = 0;
+                for (size_t i = 0; i < kRequests; ++i)
+                    for (const auto &theOutput : theProcessor.processBatch(theFields))
+                        theCount += theOutput.has_value();
+                return theCount == kRequests * theFields.size();
+            });
+        }
+        {
+            // A filtered count over a million items, against a plain loop that tests the same thing
+            const size_t kItems = 1000000;
+            std::string theArray = "{\"items\": [";
+            for (size_t i = 0; i < kItems; ++i)
+                theArray += std::to_string(i) + ",";
+            theArray.back() = ']';
+            theArray += "}";
+
+            Model theModel;
+            BufferSource theSource(theArray);
+            JSONParser(theSource).parse(&theModel);
+            const ModelNode &theItems = *theModel.getRoot().find("items");
+            reportRate("Items, plain loop", kItems, "items", [&]() {
+                size_t theCount = 0;
+                for (size_t i = 0; i < theItems.size(); ++i)
+                    theCount += i > 10;
+                return theCount == kItems - 11;
+            });
+            reportRate("Items, filter(index > 10)", kItems, "items", [&]() {
+                return theModel.createQuery().select("'items'").filter("index > 10").count() == kItems - 11;
+            });
+            reportRate("Items, sum()", kItems, "items", [&]() {
+                return theModel.createQuery().select("'items'").sum() == kItems * (kItems - 1) / 2.0;
+            });
+            reportRate("Items, max()", kItems, "items", [&]() {
+                return theModel.createQuery().select("'items'").max() == kItems - 1.0;
+            });
+            const filterPolicy theTens("value >= 10 and value < 100 or index == 0");
+            reportRate("Items, filter(value >= 10 ...)", kItems, "items", [&]() {
+                return theModel.createQuery().select("'items'").filter(theTens).count() == 91;
+            });
+            reportRate("Items, 100-item pages", 1000, "pages", [&]() {
+                bool isValid = true;
+                for (size_t i = 0; i < 1000; ++i) {
+                    const std::string theStart = std::to_string(i * 1000);
+                    const auto thePage = theModel.createQuery().select("'items'")
+                        .filter("index >= " + theStart + " and index < " + std::to_string(i * 1000 + 100)).get("*");
+                    isValid = isValid && thePage && thePage->compare(0, theStart.size() + 1, "[" + theStart) == 0;
+                }
+                return isValid;
+            });
+        }
+        reportThroughput("Model, document order", theRecords.size(), [&]() {
+            Model theModel(ModelMode::eager, KeyOrder::document);
+            BufferSource theSource(theRecords);
+            return BasicJSONParser<Model>(theSource).parse(&theModel);
+        });
+        reportThroughput("Model, huge-page arena", theRecords.size(), [&]() {
+            Model theModel(ModelMode::eager, KeyOrder::sorted, std::make_shared<Arena>(true));
+            BufferSource theSource(theRecords);
+            return BasicJSONParser<Model>(theSource).parse(&theModel);
+        });
+        reportThroughput("Model, lazy", theRecords.size(), [&]() {
+            Model theModel(ModelMode::lazy);
+            BufferSource theSource(theRecords);
+            return BasicJSONParser<Model>(theSource).parse(&theModel);
+        });
+        reportThroughput("Model, lazy + one query", theRecords.size(), [&]() {
+            Model theModel(ModelMode::lazy);
+            BufferSource theSource(theRecords);
+            return BasicJSONParser<Model>(theSource).parse(&theModel) &&
+                   theModel.createQuery().select("'records'.1000").get("'name'").has_value();
+        });
+        reportThroughput("Streamed, one query", theRecords.size(), [&]() {
+            BufferSource theSource(theRecords);
+            return CommandProcessor::processStream("select('records'.1000).get('name')", theSource).has_value();
+        });
+        reportThroughput("Streamed, whole-list count", theRecords.size(), [&]() {
+            BufferSource theSource(theRecords);
+            return CommandProcessor::processStream("select('records').count()", theSource).has_value();
+        });
+        const Projection theProjection({"'records'.0.'name'"});
+        reportThroughput("Model, projected", theRecords.size(), [&]() {
+            Model theModel;
+            BufferSource theSource(theRecords);
+            JSONParser theParser(theSource);
+            theParser.setProjection(&theProjection);
+            return theParser.parse(&theModel);
+        });
+
+        // Member lookups in one wide object: binary search when sorted, the hash index in document order
+        const size_t kWidth = 100000;
+        std::string theWide = "{";
+        std::vector<std::string> theKeys;
+        for (size_t i = 0; i < kWidth; ++i) {
+            theKeys.push_back("field_" + std::to_string(i));
+            theWide += "\"field_" + std::to_string(i * 7919 % kWidth) + "\": " + std::to_string(i) + ", ";
+        }
+        theWide += "\"last\": 0}";
+        for (const auto theOrder : {KeyOrder::sorted, KeyOrder::document}) {
+            Model theModel(ModelMode::eager, theOrder);
+            BufferSource theSource(theWide);
+            JSONParser(theSource).parse(&theModel);
+            const ModelNode &theRoot = theModel.getRoot();
+            reportRate(KeyOrder::sorted == theOrder ? "Wide object, sorted" : "Wide object, document order", kWidth, "lookups", [&]() {
+                size_t theFound = 0;
+                for (const auto &theKey : theKeys)
+                    theFound += theRoot.find(theKey) != nullptr;
+                return theFound == kWidth;
+            });
+        }
+
+        for (size_t theThreads = 2; theThreads <= std::max<size_t>(2, ThreadPool::getDefaultThreadCount()); theThreads *= 2) {
+            reportThroughput("Model, " + std::to_string(theThreads) + " threads", theRecords.size(), [&]() {
+                Model theModel;
+                BufferSource theSource(theRecords);
+                return ParallelParser(theSource, theThreads).parse(theModel);
+            });
+        }
+
+        const std::string theLines = generateLines(theDocument.size() / 8);
+        for (size_t theThreads = 1; theThreads <= ThreadPool::getDefaultThreadCount(); theThreads *= 2) {
+            reportThroughput("JSON Lines, " + std::to_string(theThreads) + " thread(s)", theLines.size(), [&]() {
+                std::vector<Model> theModels;
+                BufferSource theSource(theLines);
+                return JSONLinesParser(theSource, theThreads).parse(theModels);
+            });
+        }
+
+        for (const auto theKernel : {StructuralIndex::Kernel::scalar, StructuralIndex::Kernel::sse2,
+                                     StructuralIndex::Kernel::avx2}) {
+            if (!StructuralIndex::isSupported(theKernel))
+                continue;
+            StructuralIndex theIndex;
+            reportThroughput(std::string("Index only (") + StructuralIndex::getName(theKernel) + ")",
+                             theDocument.size(), [&]() {
+                theIndex.build(theDocument, theKernel);
+                return theIndex.size() > 0;
+            });
+        }
+
+        std::filesystem::remove(theFilePath);
+        return true;
+    }
+
+}
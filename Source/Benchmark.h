@@ -0,0 +1,15 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include <string>
+
+namespace JSONProc {
+
+    // Throughput of the parser over the available input sources, on a generated document.
+    // Set JSONPROC_BENCH_MB to change the document size; build with -DCMAKE_BUILD_TYPE=Release.
+    bool runParserBenchmark(const std::string& aPath);
+
+}
@@ -0,0 +1,390 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "FilterExpression.h"
+#include "Model.h"
+#include <cctype>
+#include <charconv>
+#include <string>
+
+namespace JSONProc {
+
+    template <typename T>
+    bool compareWith(Comparison aComparison, const T &aLeft, const T &aRight) {
+        switch (aComparison) {
+            case Comparison::equal:        return aLeft == aRight;
+            case Comparison::notEqual:     return aLeft != aRight;
+            case Comparison::less:         return aLeft < aRight;
+            case Comparison::lessEqual:    return aLeft <= aRight;
+            case Comparison::greater:      return aLeft > aRight;
+            case Comparison::greaterEqual: return aLeft >= aRight;
+            case Comparison::invalid:      break;
+        }
+        return false;
+    }
+
+    // ---Tests---
+
+    class IndexFilter : public FilterExpression {
+    public:
+        IndexFilter(Comparison aComparison, long aLimit) : comparison(aComparison), limit(aLimit) {}
+
+        bool matches(const Element &anElement) const override {
+            return !anElement.isMember && compareWith(comparison, static_cast<long>(anElement.index), limit);
+        }
+        IndexRanges getCandidates(size_t aSize) const override { return IndexRanges::compare(comparison, limit, aSize); }
+        bool isExact() const override { return true; }
+
+    protected:
+        Comparison comparison;
+        long limit;
+    };
+
+    class KeyFilter : public FilterExpression {
+    public:
+        // without aComparison, the key must contain aText
+        KeyFilter(std::string aText, Comparison aComparison = Comparison::invalid)
+            : text(std::move(aText)), comparison(aComparison) {}
+
+        bool matches(const Element &anElement) const override {
+            if (!anElement.isMember)
+                return false;
+            if (Comparison::invalid == comparison)
+                return std::string_view::npos != anElement.key.find(text);
+            return compareWith(comparison, anElement.key, std::string_view(text));
+        }
+        IndexRanges getCandidates(size_t) const override { return {}; } // list items have no keys
+        bool isExact() const override { return true; }
+
+    protected:
+        std::string text;
+        Comparison comparison;
+    };
+
+    // Value tests, one per kind of literal, so each compares the way its kind does
+    struct NumberTest {
+        bool operator()(const ModelNode &aValue) const {
+            if (ModelNode::Type::integer == aValue.getType() && isInteger)
+                return compareWith(comparison, aValue.getInteger(), integer);
+            if (ModelNode::Type::integer == aValue.getType())
+                return compareWith(comparison, static_cast<double>(aValue.getInteger()), real);
+            if (ModelNode::Type::real == aValue.getType())
+                return compareWith(comparison, aValue.getReal(), real);
+            return Comparison::notEqual == comparison;
+        }
+
+        Comparison comparison;
+        long integer;
+        double real;
+        bool isInteger;
+    };
+
+    struct StringTest {
+        bool operator()(const ModelNode &aValue) const {
+            if (ModelNode::Type::string != aValue.getType())
+                return Comparison::notEqual == comparison;
+            if (isContains)
+                return std::string_view::npos != aValue.getString().find(text);
+            return compareWith(comparison, aValue.getString(), std::string_view(text));
+        }
+
+        Comparison comparison;
+        std::string text;
+        bool isContains;
+    };
+
+    struct BoolTest {
+        bool operator()(const ModelNode &aValue) const {
+            if (ModelNode::Type::boolean != aValue.getType())
+                return Comparison::notEqual == comparison;
+            return (Comparison::equal == comparison && aValue.getBool() == value) ||
+                   (Comparison::notEqual == comparison && aValue.getBool() != value);
+        }
+
+        Comparison comparison;
+        bool value;
+    };
+
+    struct NullTest {
+        bool operator()(const ModelNode &aValue) const {
+            const bool isNull = ModelNode::Type::null == aValue.getType();
+            return (Comparison::equal == comparison && isNull) || (Comparison::notEqual == comparison && !isNull);
+        }
+
+        Comparison comparison;
+    };
+
+    // Applies a Test to the element's value, or to the member of it named by field
+    template <typename Test>
+    class ValueFilter : public FilterExpression {
+    public:
+        ValueFilter(Test aTest, std::string aField, bool isField) : test(std::move(aTest)), field(std::move(aField)), isField(isField) {}
+
+        bool matches(const Element &anElement) const override {
+            if (!isField)
+                return test(anElement.value);
+            anElement.value.expand();
+            if (ModelNode::Type::object != anElement.value.getType())
+                return false;
+            const ModelNode *theMember = anElement.value.find(field);
+            return theMember && test(*theMember);
+        }
+
+    protected:
+        Test test;
+        std::string field;
+        bool isField;
+    };
+
+    // ---Connectives---
+
+    class AndFilter : public FilterExpression {
+    public:
+        AndFilter(std::unique_ptr<const FilterExpression> aLeft, std::unique_ptr<const FilterExpression> aRight)
+            : left(std::move(aLeft)), right(std::move(aRight)) {}
+
+        bool matches(const Element &anElement) const override { return left->matches(anElement) && right->matches(anElement); }
+        IndexRanges getCandidates(size_t aSize) const override {
+            return left->getCandidates(aSize).intersect(right->getCandidates(aSize));
+        }
+        bool isExact() const override { return left->isExact() && right->isExact(); }
+
+    protected:
+        std::unique_ptr<const FilterExpression> left, right;
+    };
+
+    class OrFilter : public FilterExpression {
+    public:
+        OrFilter(std::unique_ptr<const FilterExpression> aLeft, std::unique_ptr<const FilterExpression> aRight)
+            : left(std::move(aLeft)), right(std::move(aRight)) {}
+
+        bool matches(const Element &anElement) const override { return left->matches(anElement) || right->matches(anElement); }
+        IndexRanges getCandidates(size_t aSize) const override {
+            return left->getCandidates(aSize).unite(right->getCandidates(aSize));
+        }
+        bool isExact() const override { return left->isExact() && right->isExact(); }
+
+    protected:
+        std::unique_ptr<const FilterExpression> left, right;
+    };
+
+    class NotFilter : public FilterExpression {
+    public:
+        explicit NotFilter(std::unique_ptr<const FilterExpression> anOperand) : operand(std::move(anOperand)) {}
+
+        bool matches(const Element &anElement) const override { return !operand->matches(anElement); }
+        IndexRanges getCandidates(size_t aSize) const override {
+            return operand->isExact() ? operand->getCandidates(aSize).complement(aSize) : IndexRanges::getAll(aSize);
+        }
+        bool isExact() const override { return operand->isExact(); }
+
+    protected:
+        std::unique_ptr<const FilterExpression> operand;
+    };
+
+    // ---Parsing---
+
+    struct FilterToken {
+        enum class Kind { word, number, string, comparison, open, close, end, invalid };
+
+        Kind kind;
+        std::string_view text; // strings without their quotes
+    };
+
+    // Recursive descent over: or := and {"or" and}, and := unary {"and" unary},
+    // unary := "not" unary | "(" or ")" | test
+    class FilterParser {
+    public:
+        explicit FilterParser(std::string_view aText) : rest(aText) { advance(); }
+
+        std::unique_ptr<const FilterExpression> parse() {
+            auto theExpression = parseOr();
+            return FilterToken::Kind::end == token.kind ? std::move(theExpression) : nullptr;
+        }
+
+    protected:
+        void advance() {
+            while (!rest.empty() && std::isspace(static_cast<unsigned char>(rest.front())))
+                rest.remove_prefix(1);
+            if (rest.empty()) {
+                token = {FilterToken::Kind::end, {}};
+                return;
+            }
+
+            const char theFirst = rest.front();
+            size_t theLength = 1;
+            FilterToken::Kind theKind = FilterToken::Kind::invalid;
+            if ('(' == theFirst || ')' == theFirst)
+                theKind = '(' == theFirst ? FilterToken::Kind::open : FilterToken::Kind::close;
+            else if ('\'' == theFirst || '"' == theFirst) {
+                const size_t theClose = rest.find(theFirst, 1);
+                if (theClose != std::string_view::npos) {
+                    token = {FilterToken::Kind::string, rest.substr(1, theClose - 1)};
+                    rest.remove_prefix(theClose + 1);
+                    return;
+                }
+            }
+            else if (std::string_view("=!<>").find(theFirst) != std::string_view::npos) {
+                theLength = rest.size() > 1 && '=' == rest[1] ? 2 : 1;
+                theKind = FilterToken::Kind::comparison;
+            }
+            else if (std::isdigit(static_cast<unsigned char>(theFirst)) || '-' == theFirst) {
+                while (theLength < rest.size() && std::string_view("0123456789.eE+-").find(rest[theLength]) != std::string_view::npos)
+                    ++theLength;
+                theKind = FilterToken::Kind::number;
+            }
+            else if (std::isalpha(static_cast<unsigned char>(theFirst))) {
+                while (theLength < rest.size() && (std::isalnum(static_cast<unsigned char>(rest[theLength])) || '_' == rest[theLength]))
+                    ++theLength;
+                theKind = FilterToken::Kind::word;
+            }
+
+            token = {theKind, rest.substr(0, theLength)};
+            rest.remove_prefix(theLength);
+        }
+
+        bool isWord(std::string_view aWord) const { return FilterToken::Kind::word == token.kind && aWord == token.text; }
+
+        std::unique_ptr<const FilterExpression> parseOr() {
+            auto theLeft = parseAnd();
+            while (theLeft && isWord("or")) {
+                advance();
+                auto theRight = parseAnd();
+                if (!theRight)
+                    return nullptr;
+                theLeft = std::make_unique<OrFilter>(std::move(theLeft), std::move(theRight));
+            }
+            return theLeft;
+        }
+
+        std::unique_ptr<const FilterExpression> parseAnd() {
+            auto theLeft = parseUnary();
+            while (theLeft && isWord("and")) {
+                advance();
+                auto theRight = parseUnary();
+                if (!theRight)
+                    return nullptr;
+                theLeft = std::make_unique<AndFilter>(std::move(theLeft), std::move(theRight));
+            }
+            return theLeft;
+        }
+
+        std::unique_ptr<const FilterExpression> parseUnary() {
+            if (isWord("not")) {
+                advance();
+                auto theOperand = parseUnary();
+                return theOperand ? std::make_unique<NotFilter>(std::move(theOperand)) : nullptr;
+            }
+            if (FilterToken::Kind::open == token.kind) {
+                advance();
+                auto theExpression = parseOr();
+                if (!theExpression || FilterToken::Kind::close != token.kind)
+                    return nullptr;
+                advance();
+                return theExpression;
+            }
+            return parseTest();
+        }
+
+        std::unique_ptr<const FilterExpression> parseTest() {
+            if (isWord("index")) {
+                advance();
+                const Comparison theComparison = parseComparison();
+                long theLimit = 0;
+                if (Comparison::invalid == theComparison || !parseInteger(theLimit))
+                    return nullptr;
+                advance();
+                return std::make_unique<IndexFilter>(theComparison, theLimit);
+            }
+            if (isWord("key")) {
+                advance();
+                const bool isContains = isWord("contains");
+                const Comparison theComparison = isContains ? Comparison::invalid : parseComparison();
+                if (!isContains && Comparison::invalid == theComparison)
+                    return nullptr;
+                if (isContains)
+                    advance();
+                if (FilterToken::Kind::string != token.kind)
+                    return nullptr;
+                std::string theText(token.text);
+                advance();
+                return std::make_unique<KeyFilter>(std::move(theText), theComparison);
+            }
+            if (isWord("value")) {
+                advance();
+                return parseValueTest({}, false);
+            }
+            if (FilterToken::Kind::string == token.kind) {
+                std::string theField(token.text);
+                advance();
+                return parseValueTest(std::move(theField), true);
+            }
+            return nullptr;
+        }
+
+        std::unique_ptr<const FilterExpression> parseValueTest(std::string aField, bool isField) {
+            if (isWord("contains")) {
+                advance();
+                if (FilterToken::Kind::string != token.kind)
+                    return nullptr;
+                StringTest theTest{Comparison::invalid, std::string(token.text), true};
+                advance();
+                return std::make_unique<ValueFilter<StringTest>>(std::move(theTest), std::move(aField), isField);
+            }
+
+            const Comparison theComparison = parseComparison();
+            if (Comparison::invalid == theComparison)
+                return nullptr;
+
+            std::unique_ptr<const FilterExpression> theFilter;
+            if (FilterToken::Kind::number == token.kind) {
+                NumberTest theTest{theComparison, 0, 0, parseInteger(theTest.integer)};
+                const auto theEnd = token.text.data() + token.text.size();
+                if (theTest.isInteger)
+                    theTest.real = static_cast<double>(theTest.integer);
+                else if (std::from_chars(token.text.data(), theEnd, theTest.real).ptr != theEnd)
+                    return nullptr;
+                theFilter = std::make_unique<ValueFilter<NumberTest>>(theTest, std::move(aField), isField);
+            }
+            else if (FilterToken::Kind::string == token.kind)
+                theFilter = std::make_unique<ValueFilter<StringTest>>(StringTest{theComparison, std::string(token.text), false},
+                                                                      std::move(aField), isField);
+            else if (isWord("true") || isWord("false"))
+                theFilter = std::make_unique<ValueFilter<BoolTest>>(BoolTest{theComparison, isWord("true")}, std::move(aField), isField);
+            else if (isWord("null"))
+                theFilter = std::make_unique<ValueFilter<NullTest>>(NullTest{theComparison}, std::move(aField), isField);
+            else
+                return nullptr;
+
+            advance();
+            return theFilter;
+        }
+
+        // Consumes a comparison operator
+        Comparison parseComparison() {
+            if (FilterToken::Kind::comparison != token.kind)
+                return Comparison::invalid;
+            const Comparison theComparison = filterPolicy::getComparison(std::string(token.text));
+            advance();
+            return theComparison;
+        }
+
+        // Reads the current number token as a whole number, without consuming it
+        bool parseInteger(long &aValue) const {
+            if (FilterToken::Kind::number != token.kind)
+                return false;
+            const auto theEnd = token.text.data() + token.text.size();
+            const auto theResult = std::from_chars(token.text.data(), theEnd, aValue);
+            return std::errc() == theResult.ec && theEnd == theResult.ptr;
+        }
+
+        std::string_view rest;
+        FilterToken token{FilterToken::Kind::end, {}};
+    };
+
+    std::unique_ptr<const FilterExpression> FilterExpression::parse(std::string_view aText) {
+        return FilterParser(aText).parse();
+    }
+
+}
@@ -0,0 +1,48 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include "IndexRanges.h"
+#include <memory>
+#include <string_view>
+
+namespace JSONProc {
+
+    struct ModelNode;
+
+    // A filter() condition, compiled once. Tests look at an element's index (list items), its key
+    // (object members), its value, or a member of its value, and join with and, or and not:
+    //
+    //     index >= 10 and index < 20
+    //     key contains 'id'
+    //     value > 90 or value == 'n/a'
+    //     'age' >= 18 and not ('grade' == null)
+    //
+    // Comparisons take numbers, 'strings', true, false and null, and are true only between values
+    // of the same kind (except != and `== null`). A member the element doesn't have fails every test.
+    class FilterExpression {
+    public:
+        // One element of the container being filtered
+        struct Element {
+            size_t index;         // list items only
+            std::string_view key; // object members only
+            const ModelNode &value;
+            bool isMember;
+        };
+
+        // nullptr when aText isn't a valid condition
+        static std::unique_ptr<const FilterExpression> parse(std::string_view aText);
+
+        virtual ~FilterExpression() = default;
+
+        // and / or stop at the first operand that decides them
+        virtual bool matches(const Element &anElement) const = 0;
+
+        // The items of a aSize-long list that could match; exactly those that do when isExact()
+        virtual IndexRanges getCandidates(size_t aSize) const { return IndexRanges::getAll(aSize); }
+        virtual bool isExact() const { return false; }
+    };
+
+}
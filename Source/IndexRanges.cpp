@@ -0,0 +1,97 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "IndexRanges.h"
+#include <algorithm>
+
+namespace JSONProc {
+
+    void IndexRanges::add(size_t aBegin, size_t anEnd) {
+        if (aBegin >= anEnd)
+            return;
+        if (!ranges.empty() && aBegin <= ranges.back().end) // touching ranges merge
+            ranges.back().end = std::max(ranges.back().end, anEnd);
+        else
+            ranges.push_back({aBegin, anEnd});
+    }
+
+    IndexRanges IndexRanges::getAll(size_t aSize) {
+        IndexRanges theResult;
+        theResult.add(0, aSize);
+        return theResult;
+    }
+
+    IndexRanges IndexRanges::compare(Comparison aComparison, long aLimit, size_t aSize) {
+        // where aLimit and the index after it fall in the list
+        const auto clamp = [aSize](long aValue) {
+            return aValue < 0 ? 0 : std::min(static_cast<size_t>(aValue), aSize);
+        };
+        const size_t theLimit = clamp(aLimit);
+        const size_t theNext = aLimit >= static_cast<long>(aSize) ? aSize : clamp(aLimit + 1); // aLimit + 1 overflows at LONG_MAX
+
+        IndexRanges theResult;
+        switch (aComparison) {
+            case Comparison::equal:        theResult.add(theLimit, theNext); break;
+            case Comparison::notEqual:     theResult.add(0, theLimit); theResult.add(theNext, aSize); break;
+            case Comparison::less:         theResult.add(0, theLimit); break;
+            case Comparison::lessEqual:    theResult.add(0, theNext); break;
+            case Comparison::greater:      theResult.add(theNext, aSize); break;
+            case Comparison::greaterEqual: theResult.add(theLimit, aSize); break;
+            case Comparison::invalid:      break; // no operator, so nothing matches
+        }
+        return theResult;
+    }
+
+    IndexRanges IndexRanges::intersect(const IndexRanges &anOther) const {
+        IndexRanges theResult;
+        auto theLeft = ranges.begin(), theRight = anOther.ranges.begin();
+        while (theLeft != ranges.end() && theRight != anOther.ranges.end()) {
+            theResult.add(std::max(theLeft->begin, theRight->begin), std::min(theLeft->end, theRight->end));
+            if (theLeft->end < theRight->end)
+                ++theLeft;
+            else
+                ++theRight;
+        }
+        return theResult;
+    }
+
+    IndexRanges IndexRanges::unite(const IndexRanges &anOther) const {
+        std::vector<Range> theAll(ranges);
+        theAll.insert(theAll.end(), anOther.ranges.begin(), anOther.ranges.end());
+        std::sort(theAll.begin(), theAll.end(), [](const Range &aLeft, const Range &aRight) {
+            return aLeft.begin < aRight.begin;
+        });
+
+        IndexRanges theResult;
+        for (const auto &theRange : theAll)
+            theResult.add(theRange.begin, theRange.end);
+        return theResult;
+    }
+
+    IndexRanges IndexRanges::complement(size_t aSize) const {
+        IndexRanges theResult;
+        size_t theStart = 0;
+        for (const auto &theRange : ranges) {
+            theResult.add(theStart, std::min(theRange.begin, aSize));
+            theStart = theRange.end;
+        }
+        theResult.add(theStart, aSize);
+        return theResult;
+    }
+
+    size_t IndexRanges::count() const {
+        size_t theCount = 0;
+        for (const auto &theRange : ranges)
+            theCount += theRange.end - theRange.begin;
+        return theCount;
+    }
+
+    bool IndexRanges::contains(size_t anIndex) const {
+        const auto theRange = std::upper_bound(ranges.begin(), ranges.end(), anIndex, [](size_t anIndex, const Range &aRange) {
+            return anIndex < aRange.end;
+        });
+        return theRange != ranges.end() && theRange->begin <= anIndex;
+    }
+
+}
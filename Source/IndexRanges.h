@@ -0,0 +1,42 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace JSONProc {
+
+    enum class Comparison { equal, notEqual, less, lessEqual, greater, greaterEqual, invalid };
+
+    // The list indices an index filter admits, as sorted, disjoint, half-open ranges. Consumers
+    // count them with arithmetic and visit only the items inside, however long the list is.
+    class IndexRanges {
+    public:
+        struct Range {
+            size_t begin;
+            size_t end; // one past the last index
+        };
+
+        IndexRanges() = default; // admits nothing
+        static IndexRanges getAll(size_t aSize);
+        // The indices of a aSize-long list that satisfy "index aComparison aLimit"
+        static IndexRanges compare(Comparison aComparison, long aLimit, size_t aSize);
+
+        IndexRanges intersect(const IndexRanges &anOther) const;
+        IndexRanges unite(const IndexRanges &anOther) const;
+        IndexRanges complement(size_t aSize) const; // of [0, aSize)
+
+        size_t count() const;
+        bool contains(size_t anIndex) const;
+        const std::vector<Range>& getRanges() const { return ranges; }
+
+    protected:
+        void add(size_t aBegin, size_t anEnd); // after every range so far
+
+        std::vector<Range> ranges;
+    };
+
+}
@@ -0,0 +1,98 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "InputSource.h"
+#include <fstream>
+#include <sstream>
+
+#if defined(_WIN32)
+    #define JSONPROC_NO_MMAP 1
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace JSONProc {
+
+    // ---BufferSource---
+
+    BufferSource::BufferSource(std::string_view aBuffer) : buffer(aBuffer) {}
+
+    std::string_view BufferSource::nextBlock() {
+        if (isConsumed)
+            return {};
+
+        isConsumed = true;
+        return buffer;
+    }
+
+
+    // ---MappedFileSource---
+
+    MappedFileSource::MappedFileSource(const std::string& aPath) {
+#ifdef JSONPROC_NO_MMAP
+        std::ifstream theFile(aPath, std::ios::binary);
+        if (theFile) {
+            std::ostringstream theContents;
+            theContents << theFile.rdbuf();
+            fallback = theContents.str();
+            data = fallback.data();
+            length = fallback.size();
+        }
+#else
+        const int theFile = ::open(aPath.c_str(), O_RDONLY);
+        if (theFile < 0)
+            return;
+
+        struct stat theInfo {};
+        if (::fstat(theFile, &theInfo) == 0) {
+            length = static_cast<size_t>(theInfo.st_size);
+            if (length == 0)
+                data = fallback.data(); // mmap rejects empty files
+            else {
+                void *theMapping = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, theFile, 0);
+                if (theMapping != MAP_FAILED) {
+                    ::madvise(theMapping, length, MADV_SEQUENTIAL);
+                    data = static_cast<const char*>(theMapping);
+                }
+                else
+                    length = 0;
+            }
+        }
+        ::close(theFile);
+#endif
+    }
+
+    MappedFileSource::~MappedFileSource() {
+#ifndef JSONPROC_NO_MMAP
+        if (data && length)
+            ::munmap(const_cast<char*>(data), length);
+#endif
+    }
+
+    std::string_view MappedFileSource::nextBlock() {
+        if (isConsumed || !data)
+            return {};
+
+        isConsumed = true;
+        return {data, length};
+    }
+
+
+    // ---StreamSource---
+
+    StreamSource::StreamSource(std::istream &anInput, size_t aBlockSize)
+        : input(anInput), buffer(aBlockSize) {}
+
+    std::string_view StreamSource::nextBlock() {
+        if (!input)
+            return {};
+
+        input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        return {buffer.data(), static_cast<size_t>(input.gcount())};
+    }
+
+}
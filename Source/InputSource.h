@@ -0,0 +1,79 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace JSONProc {
+
+    // Hands the parser its input as a series of raw character blocks
+    class InputSource {
+    public:
+        virtual ~InputSource() = default;
+
+        // Next block of input; an empty view means the input is exhausted.
+        // A block stays valid until the next call.
+        virtual std::string_view nextBlock() = 0;
+
+        // True when the first block is the whole input and outlives the source's later calls
+        virtual bool isContiguous() const { return false; }
+    };
+
+    //--------------------------------------------
+    // A document that is already in memory (not owned)
+    class BufferSource : public InputSource {
+    public:
+        BufferSource(std::string_view aBuffer);
+
+        std::string_view nextBlock() override;
+        bool isContiguous() const override { return true; }
+
+    protected:
+        std::string_view buffer;
+        bool isConsumed = false;
+    };
+
+    //--------------------------------------------
+    // Maps a whole file into memory and hands it out as one block
+    class MappedFileSource : public InputSource {
+    public:
+        MappedFileSource(const std::string& aPath);
+        ~MappedFileSource() override;
+
+        MappedFileSource(const MappedFileSource&) = delete;
+        MappedFileSource &operator=(const MappedFileSource&) = delete;
+
+        bool isOpen() const { return data != nullptr; }
+        size_t size() const { return length; }
+
+        std::string_view nextBlock() override;
+        bool isContiguous() const override { return true; }
+
+    protected:
+        const char *data = nullptr;
+        size_t length = 0;
+        bool isConsumed = false;
+        std::string fallback; // used where mmap isn't available
+    };
+
+    //--------------------------------------------
+    // Adapts a std::istream by reading it in large blocks
+    class StreamSource : public InputSource {
+    public:
+        static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+        StreamSource(std::istream &anInput, size_t aBlockSize = kDefaultBlockSize);
+
+        std::string_view nextBlock() override;
+
+    protected:
+        std::istream &input;
+        std::vector<char> buffer;
+    };
+
+}
@@ -0,0 +1,139 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "JSONLines.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace JSONProc {
+
+    const size_t kMinChunkSize = 64 * 1024;
+    const size_t kChunksPerThread = 4; // spare chunks even out uneven records
+
+    // The records of one run of whole lines
+    struct LinesChunk {
+        std::string_view text;
+        size_t offset = 0;
+        size_t lineCount = 0;
+        std::vector<Model> models;
+        std::vector<JSONLineError> errors; // line numbers within the chunk until they're merged
+    };
+
+    bool isBlank(std::string_view aLine) {
+        return aLine.find_first_not_of(" \t\r") == std::string_view::npos;
+    }
+
+    void parseChunk(LinesChunk &aChunk, KeyOrder anOrder) {
+        // The chunk's records share one arena, which only this thread touches
+        const auto theArena = std::make_shared<Arena>();
+        std::string_view theRest = aChunk.text;
+        size_t theOffset = aChunk.offset;
+        while (!theRest.empty()) {
+            const size_t theLength = std::min(theRest.find('\n'), theRest.size());
+            const std::string_view theLine = theRest.substr(0, theLength);
+            ++aChunk.lineCount;
+
+            if (!isBlank(theLine)) {
+                Model theModel(ModelMode::eager, anOrder, theArena);
+                BufferSource theSource(theLine);
+                if (BasicJSONParser<Model>(theSource).parse(&theModel))
+                    aChunk.models.push_back(std::move(theModel));
+                else
+                    aChunk.errors.push_back({aChunk.lineCount, theOffset});
+            }
+
+            const size_t theNext = std::min(theLength + 1, theRest.size());
+            theRest.remove_prefix(theNext);
+            theOffset += theNext;
+        }
+    }
+
+    // Splits aDocument into about aCount pieces that each end after a newline
+    std::vector<LinesChunk> splitLines(std::string_view aDocument, size_t aCount) {
+        std::vector<LinesChunk> theChunks;
+        size_t theStart = 0;
+        for (size_t i = 1; i <= aCount && theStart < aDocument.size(); ++i) {
+            size_t theEnd = aDocument.size();
+            if (i < aCount) {
+                const size_t theTarget = std::max(theStart, aDocument.size() / aCount * i);
+                const size_t theNewline = aDocument.find('\n', theTarget);
+                theEnd = theNewline == std::string_view::npos ? aDocument.size() : theNewline + 1;
+            }
+            LinesChunk theChunk;
+            theChunk.text = aDocument.substr(theStart, theEnd - theStart);
+            theChunk.offset = theStart;
+            theChunks.push_back(std::move(theChunk));
+            theStart = theEnd;
+        }
+        return theChunks;
+    }
+
+
+    // ---JSONLinesParser---
+
+    JSONLinesParser::JSONLinesParser(InputSource &aSource, size_t aThreadCount, KeyOrder anOrder)
+        : source(aSource), threadCount(aThreadCount ? aThreadCount : 1), keyOrder(anOrder) {}
+
+    std::string_view JSONLinesParser::readDocument() {
+        std::string_view theDocument = source.nextBlock();
+        if (!source.isContiguous()) {
+            document.assign(theDocument);
+            for (auto theBlock = source.nextBlock(); !theBlock.empty(); theBlock = source.nextBlock())
+                document.append(theBlock);
+            theDocument = document;
+        }
+        return theDocument;
+    }
+
+    bool JSONLinesParser::parse(std::vector<Model> &aModels) {
+        errors.clear();
+        const std::string_view theDocument = readDocument();
+
+        const size_t theChunkCount = std::max<size_t>(1, std::min(theDocument.size() / kMinChunkSize,
+                                                                  threadCount * kChunksPerThread));
+        std::vector<LinesChunk> theChunks = splitLines(theDocument, theChunkCount);
+
+        if (threadCount > 1 && theChunks.size() > 1) {
+            ThreadPool thePool(std::min(threadCount, theChunks.size()));
+            thePool.parallelFor(theChunks.size(), [&](size_t anIndex) { parseChunk(theChunks[anIndex], keyOrder); });
+        }
+        else {
+            for (auto &theChunk : theChunks)
+                parseChunk(theChunk, keyOrder);
+        }
+
+        // Stitch the chunks back together in order
+        size_t theLines = 0;
+        for (auto &theChunk : theChunks) {
+            std::move(theChunk.models.begin(), theChunk.models.end(), std::back_inserter(aModels));
+            for (auto theError : theChunk.errors) {
+                theError.line += theLines;
+                errors.push_back(theError);
+            }
+            theLines += theChunk.lineCount;
+        }
+
+        return errors.empty();
+    }
+
+    bool JSONLinesParser::parse(Model &aModel) {
+        std::vector<Model> theRecords;
+        const bool theResult = parse(theRecords);
+        if (theRecords.size() > ModelNode::kMaxSize)
+            return false; //more records than the root list can count
+
+        Arena &theArena = aModel.getArena();
+        std::vector<ModelNode> theItems;
+        theItems.reserve(theRecords.size());
+        for (auto &theRecord : theRecords) {
+            theItems.push_back(theRecord.getRoot());
+            theArena.keep(theRecord.shareArena());
+        }
+
+        aModel.setRoot(ModelNode::makeList(theItems.data(), theItems.size(), theArena));
+        return theResult;
+    }
+
+}
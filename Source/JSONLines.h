@@ -0,0 +1,48 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include "InputSource.h"
+#include "Model.h"
+#include "ThreadPool.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace JSONProc {
+
+    // A JSON Lines record that failed to parse
+    struct JSONLineError {
+        size_t line;   // counting from 1
+        size_t offset; // of the line's first character
+    };
+
+    // Parses newline-delimited JSON (one object or list per line) on a thread pool.
+    // Records keep their input order whatever the thread count; blank lines are skipped.
+    class JSONLinesParser {
+    public:
+        JSONLinesParser(InputSource &aSource, size_t aThreadCount = ThreadPool::getDefaultThreadCount(),
+                        KeyOrder anOrder = KeyOrder::sorted);
+
+        // One Model per valid record
+        bool parse(std::vector<Model> &aModels);
+
+        // A single Model whose root lists the valid records
+        bool parse(Model &aModel);
+
+        // Records that failed in the last parse, in line order; parse() is false when there are any
+        const std::vector<JSONLineError>& getErrors() const { return errors; }
+
+    protected:
+        std::string_view readDocument();
+
+        InputSource &source;
+        size_t threadCount;
+        KeyOrder keyOrder; // of every record's objects
+        std::string document; // copy of a source that isn't contiguous
+        std::vector<JSONLineError> errors;
+    };
+
+}
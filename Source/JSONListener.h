@@ -0,0 +1,92 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace JSONProc {
+
+	// Type of the value
+	enum class Element {
+		object, array, closing, constant, quoted, unknown
+	};
+
+	class JSONListener {
+	public:
+		// Remember, all virtual objects need a virtual destructor
+		virtual ~JSONListener() = default;
+
+		// Add basic key-value data types (bool, number, or string)
+		virtual bool addKeyValuePair(const std::string& aKey, const std::string& aValue, Element aType) = 0;
+
+		// Add values to a list
+		virtual bool addItem(const std::string& aValue, Element aType) = 0;
+
+		// Start of an object or list container ('{' or '[')
+		virtual bool openContainer(const std::string& aKey, Element aType) = 0;
+
+		// End of an object or list container ('}' or ']')
+		virtual bool closeContainer(const std::string& aKey, Element aType) = 0;
+
+		// True once the listener has all it wants. A callback that returns false then stops the
+		// parse successfully, rather than failing it, and the rest of the input goes unread.
+		virtual bool isDone() const { return false; }
+
+	};
+
+	// Same events as JSONListener, but keys and values are views into the parser's input
+	// that are only valid during the call; copy whatever you keep. isEscaped is set when the
+	// value still holds backslash escapes.
+	class JSONViewListener {
+	public:
+		virtual ~JSONViewListener() = default;
+
+		// Strings; constants arrive through the typed callbacks below
+		virtual bool addKeyValuePair(std::string_view aKey, std::string_view aValue, Element aType, bool isEscaped) = 0;
+		virtual bool addItem(std::string_view aValue, Element aType, bool isEscaped) = 0;
+
+		virtual bool openContainer(std::string_view aKey, Element aType) = 0;
+		virtual bool closeContainer(std::string_view aKey, Element aType) = 0;
+
+		// Constants, converted once by the parser. aKey is empty inside a list, as in openContainer.
+		virtual bool addInteger(std::string_view aKey, std::int64_t aValue) = 0;
+		virtual bool addDouble(std::string_view aKey, double aValue) = 0;
+		virtual bool addBool(std::string_view aKey, bool aValue) = 0;
+		virtual bool addNull(std::string_view aKey) = 0;
+
+		// As in JSONListener: once this is true, a callback's false stops the parse successfully
+		virtual bool isDone() const { return false; }
+	};
+
+	//--------------------------------------------
+	// The value of a constant's text: integers that fit in 64 bits, then doubles, true, false or null
+	struct JSONConstant {
+		enum class Kind { integer, real, boolean, null, invalid };
+
+		static JSONConstant parse(std::string_view aText);
+
+		Kind kind = Kind::invalid;
+		std::int64_t integer = 0;
+		double real = 0;
+		bool boolean = false;
+	};
+
+	//--------------------------------------------
+	// Ignores every event, so parsing only validates the input
+	class NullListener final : public JSONViewListener {
+	public:
+		bool addKeyValuePair(std::string_view, std::string_view, Element, bool) override { return true; }
+		bool addItem(std::string_view, Element, bool) override { return true; }
+		bool openContainer(std::string_view, Element) override { return true; }
+		bool closeContainer(std::string_view, Element) override { return true; }
+		bool addInteger(std::string_view, std::int64_t) override { return true; }
+		bool addDouble(std::string_view, double) override { return true; }
+		bool addBool(std::string_view, bool) override { return true; }
+		bool addNull(std::string_view) override { return true; }
+	};
+
+}
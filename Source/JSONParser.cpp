@@ -6,188 +6,162 @@
 
 #include "JSONParser.h"
 #include <cctype>
+#include <charconv>
 #include <stdexcept>
 #include <cstring>
 
 namespace JSONProc {
 
-	using Actions = bool (JSONParser::*)(char aChar, JSONState &aState, JSONListener *);
-	using parseCallback = bool(char aChar);
+	template class BasicJSONParser<JSONViewListener>;
 
-	// ---Basic Parsing Utilities---
+	// Hands a JSONListener the copies it expects. The parser gives it constants as text,
+	// so the typed callbacks are never used.
+	class StringListenerAdapter : public JSONViewListener {
+	public:
+		StringListenerAdapter(JSONListener &aListener) : listener(aListener) {}
 
-	const char kColon = ':';
-	const char kComma = ',';
-	const char kQuote = '"';
-	const char kBraceOpen = '{';
-	const char kBraceClose = '}';
-	const char kBracketOpen = '[';
-	const char kBracketClose = ']';
+		bool addKeyValuePair(std::string_view aKey, std::string_view aValue, Element aType, bool) override {
+			return listener.addKeyValuePair(std::string(aKey), std::string(aValue), aType);
+		}
 
-	bool isWhitespace(char aChar) {
-		static const char *theWS = " \t\r\n\b\xff";
-		return strchr(theWS, aChar);
-	}
+		bool addItem(std::string_view aValue, Element aType, bool) override {
+			return listener.addItem(std::string(aValue), aType);
+		}
+
+		bool openContainer(std::string_view aKey, Element aType) override {
+			return listener.openContainer(std::string(aKey), aType);
+		}
+
+		bool closeContainer(std::string_view aKey, Element aType) override {
+			return listener.closeContainer(std::string(aKey), aType);
+		}
 
-	bool isColon(char aChar) { return kColon == aChar; }
-	bool isComma(char aChar) { return kComma == aChar; }
-	bool isQuote(char aChar) { return kQuote == aChar; }
-	bool isNonAlphanum(char aChar) { return !isalnum(aChar) && aChar != '.'; }
+		bool addInteger(std::string_view, std::int64_t) override { return false; }
+		bool addDouble(std::string_view, double) override { return false; }
+		bool addBool(std::string_view, bool) override { return false; }
+		bool addNull(std::string_view) override { return false; }
 
-	std::string readUntil(std::istream &anInput, parseCallback aCallback, bool addTerminal) {
-		std::string theResult;
+		bool isDone() const override { return listener.isDone(); }
 
-		while (!anInput.eof() && !(*aCallback)(anInput.peek()))
-			theResult += anInput.get();
+	protected:
+		JSONListener &listener;
+	};
 
-		if (addTerminal)
-			if (!anInput.eof())
-				theResult += anInput.get();
 
-		return theResult;
+	// ---JSONConstant---
+
+	// Skips a run of digits, and tells whether there was one
+	bool skipDigits(std::string_view &aText) {
+		size_t theCount = 0;
+		while (theCount < aText.size() && aText[theCount] >= '0' && aText[theCount] <= '9')
+			++theCount;
+		aText.remove_prefix(theCount);
+		return theCount > 0;
 	}
 
-	bool skipWhile(std::istream &anInput, parseCallback aCallback) {
-		while (!anInput.eof() && (*aCallback)(anInput.peek())) {
-			anInput.get();
+	// RFC 8259's number: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?, so none of the nan, inf,
+	// 007, 1. or +1 that std::from_chars also reads
+	bool isJSONNumber(std::string_view aText) {
+		if (!aText.empty() && '-' == aText.front())
+			aText.remove_prefix(1);
+		if (aText.empty() || ('0' == aText.front() && aText.size() > 1 && aText[1] >= '0' && aText[1] <= '9'))
+			return false;
+		if (!skipDigits(aText))
+			return false;
+		if (!aText.empty() && '.' == aText.front()) {
+			aText.remove_prefix(1);
+			if (!skipDigits(aText))
+				return false;
+		}
+		if (!aText.empty() && ('e' == aText.front() || 'E' == aText.front())) {
+			aText.remove_prefix(1);
+			if (!aText.empty() && ('+' == aText.front() || '-' == aText.front()))
+				aText.remove_prefix(1);
+			if (!skipDigits(aText))
+				return false;
 		}
-		return true;
+		return aText.empty();
 	}
 
-	bool skipIfChar(std::istream &anInput, char aChar) {
-		return (aChar == anInput.peek()) && aChar == anInput.get();
+	JSONConstant JSONConstant::parse(std::string_view aText) {
+		JSONConstant theConstant;
+		const char *theEnd = aText.data() + aText.size();
+
+		if (!isJSONNumber(aText)) {
+			if ("true" == aText || "false" == aText) {
+				theConstant.kind = Kind::boolean;
+				theConstant.boolean = "true" == aText;
+			}
+			else if ("null" == aText)
+				theConstant.kind = Kind::null;
+			return theConstant;
+		}
+
+		const auto theInteger = std::from_chars(aText.data(), theEnd, theConstant.integer);
+		if (std::errc() == theInteger.ec && theEnd == theInteger.ptr) {
+			theConstant.kind = Kind::integer;
+			return theConstant;
+		}
+
+		// Fractions, exponents and integers too large for 64 bits
+		const auto theReal = std::from_chars(aText.data(), theEnd, theConstant.real);
+		if (std::errc() == theReal.ec && theEnd == theReal.ptr)
+			theConstant.kind = Kind::real;
+		return theConstant;
 	}
 
 
 	// ---JSONParser---
 
-	JSONParser::JSONParser(std::istream &anInput) : input(anInput) {
-		anInput >> std::skipws;
-	}
+	JSONParser::JSONParser(std::istream &anInput, ParseMode aMode) : BasicJSONParser(anInput, aMode) {}
+
+	JSONParser::JSONParser(InputSource &aSource, ParseMode aMode) : BasicJSONParser(aSource, aMode) {}
+
+	JSONParser::JSONParser() = default;
 
 	bool JSONParser::parse(JSONListener *aListener) {
-		if (willParse(aListener)) {
-			bool isValid = true;
-			while (isValid) {
-				skipWhile(input, isWhitespace);
-				if (input.eof())
-					break;
-
-				const char theChar = input.get();
-				isValid = parseElements(theChar, aListener);
-			}
+		if (!aListener)
+			return parse(static_cast<JSONViewListener*>(nullptr));
 
-			return didParse(isValid);
-		}
-		return true;
+		StringListenerAdapter theAdapter(*aListener);
+		deliversText = true;
+		return parse(&theAdapter);
 	}
 
-	bool JSONParser::didParse(bool aState) {
-		return aState;
+	bool JSONParser::parse(JSONViewListener *aListener) {
+		NullListener theNullListener;
+		return BasicJSONParser::parse(aListener ? aListener : &theNullListener);
 	}
 
-	bool JSONParser::willParse(JSONListener *aListener) {
-		input >> std::skipws;
-		if (kBraceOpen == input.get()) {
-			return handleOpenContainer(Element::object, aListener); // Open default container...
-		}
-		return false;
-	}
 
+	// ---JSONPushParser---
 
-	bool JSONParser::handleOpenContainer(Element aType, JSONListener *aListener) {
-		const JSONState theState(tempKey, aType);
-		tempKey = "";
-		states.push(theState);
-		return (!aListener) || aListener->openContainer(theState.key, aType);
+	JSONPushParser::JSONPushParser(JSONListener *aListener) : listener(&nullListener) {
+		if (aListener) {
+			adapter = std::make_unique<StringListenerAdapter>(*aListener);
+			listener = adapter.get();
+			deliversText = true;
+		}
 	}
 
-	bool JSONParser::handleCloseContainer(Element aType, JSONListener *aListener) {
-		tempKey = "";
-		const std::string theKey(states.top().key);
-		if (!states.empty())
-			states.pop();
+	JSONPushParser::JSONPushParser(JSONViewListener *aListener) : listener(aListener ? aListener : &nullListener) {}
 
-		return (!aListener) || aListener->closeContainer(theKey, aType);
+	bool JSONPushParser::feed(const char *aData, size_t aLength) {
+		// An empty block would read as the end of the input
+		if (isValid && !isFinished && aLength > 0)
+			isValid = consume(std::string_view(aData, aLength), false, listener);
+		return isValid;
 	}
 
-
-	Element determineType(char aChar) {
-		const char *kConstantChars = "01234567890tfn";
-		switch (aChar) {
-			case kQuote:
-				return Element::quoted;
-			case kBraceOpen:
-				return Element::object;
-			case kBracketOpen:
-				return Element::array;
-			case kBraceClose:
-			case kBracketClose:
-				return Element::closing;
-			default:
-				return strchr(kConstantChars, aChar) ? Element::constant : Element::unknown;
-		}
+	bool JSONPushParser::feed(std::string_view aData) {
+		return feed(aData.data(), aData.size());
 	}
 
-	// Parse all possible elements
-	bool JSONParser::parseElements(char aChar, JSONListener *aListener) {
-		bool theResult = true;
-
-		const Element theType = determineType(aChar);
-		const JSONState &theTop = states.top();
-		std::string theValue;
-
-		switch (theType) {
-			case Element::object:
-			case Element::array:
-				theResult = handleOpenContainer(theType, aListener);
-				break;
-
-			case Element::closing:
-				theResult = handleCloseContainer(theTop.type, aListener);
-				skipWhile(input, isWhitespace);
-				skipIfChar(input, kComma);
-				break;
-
-			case Element::quoted:
-				theValue = readUntil(input, isQuote, false);
-				skipIfChar(input, kQuote);
-				skipWhile(input, isWhitespace);
-				skipIfChar(input, kComma);
-
-				if (Element::object == theTop.type) {
-					if (kColon == input.peek()) {
-						input.get(); // Skip it...
-						tempKey = theValue;
-					}
-					else {
-						theResult = (!aListener) || aListener->addKeyValuePair(tempKey, theValue, theType);
-					}
-				}
-				else
-					theResult = (!aListener) || aListener->addItem(theValue, theType);
-
-				break;
-
-			case Element::constant:
-				theValue = readUntil(input, isNonAlphanum, false);
-				theValue.insert(0, 1, aChar);
-				skipWhile(input, isWhitespace);
-				skipIfChar(input, kComma);
-
-				if (Element::object == theTop.type)
-					theResult = (!aListener) || aListener->addKeyValuePair(tempKey, theValue, theType);
-				else
-					theResult = (!aListener) || aListener->addItem(theValue, theType);
-
-				break;
-
-			default:
-				break;
-		}
-
-		skipWhile(input, isWhitespace);
-		return theResult;
+	bool JSONPushParser::finish() {
+		if (isValid && !isFinished)
+			isValid = didParse(consume({}, true, listener));
+		isFinished = true;
+		return isValid;
 	}
 
 }
@@ -5,66 +5,53 @@
 
 #pragma once
 
+#include "BasicJSONParser.h"
+#include "InputSource.h"
+#include "JSONListener.h"
 #include <iostream>
-#include <stack>
+#include <memory>
 
 namespace JSONProc {
 
-	// Type of the value
-	enum class Element {
-		object, array, closing, constant, quoted, unknown
-	};
-
-	class JSONListener {
-	public:
-		// Remember, all virtual objects need a virtual destructor
-		virtual ~JSONListener() = default;
-
-		// Add basic key-value data types (bool, number, or string)
-		virtual bool addKeyValuePair(const std::string& aKey, const std::string& aValue, Element aType) = 0;
-
-		// Add values to a list
-		virtual bool addItem(const std::string& aValue, Element aType) = 0;
-
-		// Start of an object or list container ('{' or '[')
-		virtual bool openContainer(const std::string& aKey, Element aType) = 0;
-
-		// End of an object or list container ('}' or ']')
-		virtual bool closeContainer(const std::string& aKey, Element aType) = 0;
-
-	};
-
 	//--------------------------------------------
-	// Used for parsing to keep track of state
-	struct JSONState {
-		JSONState(const std::string& aKey, Element aType = Element::object) : key(aKey), type(aType) {}
+	// Parses for any listener, through its virtual callbacks; without one it only validates
+	class JSONParser : public BasicJSONParser<JSONViewListener> {
+	public:
+		JSONParser(std::istream &anInputStream, ParseMode aMode = ParseMode::streaming);
+		JSONParser(InputSource &aSource, ParseMode aMode = ParseMode::streaming);
 
-		JSONState(const JSONState &aCopy)
-			: key(aCopy.key), type(aCopy.type) {}
+		bool parse(JSONListener *aListener = nullptr);
+		bool parse(JSONViewListener *aListener);
 
-		std::string key;
-		Element type;
+	protected:
+		JSONParser(); // input is pushed by JSONPushParser
 	};
 
 	//--------------------------------------------
-	class JSONParser {
+	// Parses a document handed over in pieces as it arrives, e.g. from a pipe or socket.
+	// The document may be split at any byte; the events match a parse() of the whole.
+	class JSONPushParser : protected JSONParser {
 	public:
-		JSONParser(std::istream &anInputStream);
+		JSONPushParser(JSONListener *aListener = nullptr);
+		JSONPushParser(JSONViewListener *aListener);
 
-		bool parse(JSONListener *aListener = nullptr);
-
-	protected:
-		bool willParse(JSONListener *aListener = nullptr);
-		bool didParse(bool aStatus);
+		// aData only needs to live for the call. Returns false once the input is invalid.
+		bool feed(const char *aData, size_t aLength);
+		bool feed(std::string_view aData);
 
-		bool parseElements(char aChar, JSONListener *aListener);
+		// Call once the input has ended, to flush a trailing constant
+		bool finish();
 
-		bool handleOpenContainer(Element aType, JSONListener *aListener);
-		bool handleCloseContainer(Element aType, JSONListener *);
+		// Once the listener stops the parse, later input is accepted and ignored
+		using JSONParser::wasStopped;
+		using JSONParser::getBytesConsumed;
 
-		std::stack<JSONState> states;
-		std::string tempKey;
-		std::istream &input;
+	protected:
+		JSONViewListener *listener;
+		std::unique_ptr<JSONViewListener> adapter; // wraps a JSONListener
+		NullListener nullListener;
+		bool isValid = true;
+		bool isFinished = false;
 	};
 
 }
@@ -0,0 +1,64 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace JSONProc {
+
+    // Holds the aCapacity most recently used values. Every find() counts as a hit or a miss,
+    // so the counts show whether the capacity fits the workload. Not thread safe.
+    template <typename Key, typename Value>
+    class LRUCache {
+    public:
+        explicit LRUCache(size_t aCapacity) : capacity(aCapacity ? aCapacity : 1) {}
+
+        // The cached value, now the most recent; nullptr when it isn't cached
+        const Value* find(const Key &aKey) {
+            const auto thePosition = positions.find(aKey);
+            if (thePosition == positions.end()) {
+                ++misses;
+                return nullptr;
+            }
+            ++hits;
+            entries.splice(entries.begin(), entries, thePosition->second);
+            return &thePosition->second->second;
+        }
+
+        // Adds or replaces aKey's value, evicting the least recently used past capacity
+        const Value& insert(const Key &aKey, Value aValue) {
+            if (const auto thePosition = positions.find(aKey); thePosition != positions.end()) {
+                thePosition->second->second = std::move(aValue);
+                entries.splice(entries.begin(), entries, thePosition->second);
+                return entries.front().second;
+            }
+            if (entries.size() >= capacity) {
+                positions.erase(entries.back().first);
+                entries.pop_back();
+            }
+            entries.emplace_front(aKey, std::move(aValue));
+            positions.emplace(aKey, entries.begin());
+            return entries.front().second;
+        }
+
+        size_t size() const { return entries.size(); }
+        size_t getCapacity() const { return capacity; }
+        size_t getHits() const { return hits; }
+        size_t getMisses() const { return misses; }
+
+    protected:
+        using Entries = std::list<std::pair<Key, Value>>;
+
+        size_t capacity;
+        Entries entries; // most recently used first
+        std::unordered_map<Key, typename Entries::iterator> positions;
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+}
@@ -3,27 +3,232 @@
 //
 
 #include "Model.h"
+#include "NumberKernels.h"
+#include "ThreadPool.h"
 
+#include <algorithm>
+#include <functional>
 
 #include "Debug.h"
 
 namespace JSONProc {
 
+    // ----------ModelNode------------
+
+    ModelNode ModelNode::makeInteger(long aValue) {
+        ModelNode theNode(Type::integer);
+        theNode.store(aValue);
+        return theNode;
+    }
+
+    ModelNode ModelNode::makeReal(double aValue) {
+        ModelNode theNode(Type::real);
+        theNode.store(aValue);
+        return theNode;
+    }
+
+    ModelNode ModelNode::makeBool(bool aValue) {
+        ModelNode theNode(Type::boolean);
+        theNode.store(aValue);
+        return theNode;
+    }
+
+    ModelNode ModelNode::makeString(std::string_view aValue, Arena &anArena) {
+        ASSERT(aValue.size() <= kMaxSize);
+        ModelNode theNode(Type::string);
+        if (aValue.size() <= kInlineLength) {
+            std::memcpy(theNode.data, aValue.data(), aValue.size());
+            theNode.detail = static_cast<std::uint8_t>(aValue.size());
+        }
+        else {
+            char *theCopy = static_cast<char*>(anArena.allocate(aValue.size(), 1));
+            std::memcpy(theCopy, aValue.data(), aValue.size());
+            theNode.store<const char*>(theCopy);
+            theNode.store(static_cast<std::uint32_t>(aValue.size()), kSizeOffset);
+        }
+        return theNode;
+    }
+
+    ModelNode ModelNode::makeList(const ModelNode *anItems, size_t aCount, Arena &anArena) {
+        ASSERT(aCount <= kMaxSize);
+        ModelNode theNode(Type::list);
+        if (aCount) {
+            auto *theItems = static_cast<ModelNode*>(anArena.allocate(aCount * sizeof(ModelNode), alignof(ModelNode)));
+            std::uninitialized_copy(anItems, anItems + aCount, theItems);
+            theNode.store(theItems);
+            theNode.store(static_cast<std::uint32_t>(aCount), kSizeOffset);
+        }
+        return theNode;
+    }
+
+    ModelNode ModelNode::makeListView(ModelNode *anItems, size_t aCount) {
+        ASSERT(aCount <= kMaxSize);
+        ModelNode theNode(Type::list);
+        theNode.store(anItems);
+        theNode.store(static_cast<std::uint32_t>(aCount), kSizeOffset);
+        return theNode;
+    }
+
+    size_t ModelNode::getSlotCount(size_t aCount) {
+        size_t theCount = 1;
+        while (theCount < aCount * 2)
+            theCount *= 2;
+        return theCount;
+    }
+
+    //the slot holding aKey's member, or the empty slot where it would go
+    std::uint32_t* ModelNode::findSlot(const Member *aMembers, std::uint32_t *aSlots, size_t aSlotCount, std::string_view aKey) {
+        const size_t theMask = aSlotCount - 1;
+        for (size_t i = std::hash<std::string_view>()(aKey) & theMask;; i = (i + 1) & theMask) {
+            if (kEmptySlot == aSlots[i] || aMembers[aSlots[i]].key.getString() == aKey)
+                return &aSlots[i];
+        }
+    }
+
+    ModelNode ModelNode::makeObject(Member *aFirst, Member *aLast, Arena &anArena, KeyOrder anOrder) {
+        ASSERT(static_cast<size_t>(aLast - aFirst) <= kMaxSize);
+        if (KeyOrder::sorted == anOrder) {
+            auto isBefore = [](const Member &aLeft, const Member &aRight) {
+                return aLeft.key.getString() < aRight.key.getString();
+            };
+            std::stable_sort(aFirst, aLast, isBefore);
+            aLast = std::unique(aFirst, aLast, [](const Member &aLeft, const Member &aRight) {
+                return aLeft.key.getString() == aRight.key.getString(); //the first of repeated keys wins
+            });
+        }
+        else if (static_cast<size_t>(aLast - aFirst) <= kLinearScanLimit) {
+            Member *theEnd = aFirst;
+            for (Member *theMember = aFirst; theMember != aLast; ++theMember) {
+                const auto theKey = theMember->key.getString();
+                if (std::none_of(aFirst, theEnd, [theKey](const Member &aKept) { return aKept.key.getString() == theKey; }))
+                    *theEnd++ = *theMember;
+            }
+            aLast = theEnd;
+        }
+        else { //too wide to compare every pair, so drop repeats through a scratch index
+            std::vector<std::uint32_t> theSlots(getSlotCount(static_cast<size_t>(aLast - aFirst)), kEmptySlot);
+            Member *theEnd = aFirst;
+            for (Member *theMember = aFirst; theMember != aLast; ++theMember) {
+                std::uint32_t *theSlot = findSlot(aFirst, theSlots.data(), theSlots.size(), theMember->key.getString());
+                if (kEmptySlot == *theSlot) {
+                    *theEnd = *theMember;
+                    *theSlot = static_cast<std::uint32_t>(theEnd++ - aFirst);
+                }
+            }
+            aLast = theEnd;
+        }
+
+        ModelNode theNode(Type::object);
+        theNode.detail = static_cast<std::uint8_t>(anOrder);
+        if (const auto theCount = static_cast<size_t>(aLast - aFirst)) {
+            const bool isIndexed = KeyOrder::document == anOrder && theCount > kLinearScanLimit;
+            const size_t theSlotCount = isIndexed ? getSlotCount(theCount) : 0;
+            auto *theMembers = static_cast<Member*>(anArena.allocate(theCount * sizeof(Member) + theSlotCount * sizeof(std::uint32_t),
+                                                                     alignof(Member)));
+            std::uninitialized_copy(aFirst, aLast, theMembers);
+            if (isIndexed) {
+                auto *theSlots = reinterpret_cast<std::uint32_t*>(theMembers + theCount);
+                std::fill(theSlots, theSlots + theSlotCount, kEmptySlot);
+                for (size_t i = 0; i < theCount; ++i)
+                    *findSlot(theMembers, theSlots, theSlotCount, theMembers[i].key.getString()) = static_cast<std::uint32_t>(i);
+            }
+            theNode.store(theMembers);
+            theNode.store(static_cast<std::uint32_t>(theCount), kSizeOffset);
+        }
+        return theNode;
+    }
+
+    ModelNode ModelNode::makeDeferred(const LazySource *aSource, ParseTape::Index anIndex) {
+        ModelNode theNode(Type::deferred);
+        theNode.store(aSource);
+        theNode.store(anIndex, kSizeOffset);
+        return theNode;
+    }
+
+    std::string_view ModelNode::getString() const {
+        if (kNotInline == detail)
+            return {load<const char*>(), size()};
+        return {data, detail};
+    }
+
+    ModelNode* ModelNode::find(std::string_view aKey) const {
+        Member *theFirst = getMembers(), *theLast = theFirst + size();
+        if (KeyOrder::document == getKeyOrder()) {
+            if (size() <= kLinearScanLimit) {
+                Member *theMember = std::find_if(theFirst, theLast, [aKey](const Member &aMember) { return aMember.key.getString() == aKey; });
+                return theMember != theLast ? &theMember->value : nullptr;
+            }
+            const std::uint32_t theSlot = *findSlot(theFirst, reinterpret_cast<std::uint32_t*>(theLast), getSlotCount(size()), aKey);
+            return kEmptySlot != theSlot ? &theFirst[theSlot].value : nullptr;
+        }
+
+        Member *theMember = std::lower_bound(theFirst, theLast, aKey, [](const Member &aMember, std::string_view aKey) {
+            return aMember.key.getString() < aKey;
+        });
+        return theMember != theLast && theMember->key.getString() == aKey ? &theMember->value : nullptr;
+    }
+
+    std::string ModelNode::toString() const {
+        expand();
+        switch (type) {
+            case Type::null:     return "null";
+            case Type::boolean:  return getBool() ? "true" : "false";
+            case Type::real:     return std::to_string(getReal()); //ask about behavior of trailing zeroes
+            case Type::integer:  return std::to_string(getInteger());
+            case Type::string:   return "\"" + std::string(getString()) + "\"";
+            case Type::deferred: return ""; //expanded above
+            case Type::list: {
+                std::string output = "[";
+                for (size_t i = 0; i < size(); ++i) {
+                    output += getItems()[i].toString();
+                    output += i + 1 < size() ? ", " : "]";
+                }
+                return output;
+            }
+            case Type::object: {
+                std::string output = "{";
+                for (size_t i = 0; i < size(); ++i) {
+                    const Member &theMember = getMembers()[i];
+                    output += "\"" + std::string(theMember.key.getString()) + "\": " + theMember.value.toString();
+                    output += i + 1 < size() ? ", " : "}";
+                }
+                return output;
+            }
+        }
+        return "";
+    }
+
 	// ----------Model Class------------
     //used to create the model
 
     Model::Model() = default;
 
+    Model::Model(ModelMode aMode, KeyOrder anOrder, std::shared_ptr<Arena> anArena)
+        : arena(std::move(anArena)), keyOrder(anOrder) {
+        if (ModelMode::lazy == aMode) {
+            tape = std::make_shared<ParseTape>();
+            expansion = std::make_shared<std::recursive_mutex>();
+        }
+    }
+
 	Model::Model(ModelNode &_rootNode){
         this->rootNode = _rootNode;
     }
 
 	Model::Model(const Model& aModel) {
+        this->arena = aModel.arena;
         this->rootNode = aModel.rootNode;
+        this->tape = aModel.tape;
+        this->expansion = aModel.expansion;
+        this->keyOrder = aModel.keyOrder;
 	}
 
 	Model &Model::operator=(const Model& aModel) {
+        this->arena = aModel.arena;
         this->rootNode = aModel.rootNode;
+        this->tape = aModel.tape;
+        this->expansion = aModel.expansion;
+        this->keyOrder = aModel.keyOrder;
 		return *this;
 	}
 
@@ -32,6 +237,8 @@ namespace JSONProc {
 	}
 
     ModelNode& Model::getRoot() {
+        const auto theLock = expansion ? std::unique_lock<std::recursive_mutex>(*expansion) : std::unique_lock<std::recursive_mutex>();
+        rootNode.expand();
         return rootNode;
     }
 
@@ -39,125 +246,184 @@ namespace JSONProc {
         rootNode = newRootNode;
     }
 
-    //figure out what type the value is and set the variant in temp.value to that type
-    void Model::populateNode(ModelNode* temp, const std::string &aValue, JSONProc::Element aType) {
+    //whole numbers are kept as longs, whichever way they were written
+    ModelNode ModelNode::makeNumber(double aValue) {
+        const double kLongLimit = 9223372036854775808.0; // 2^63
+        if (std::trunc(aValue) == aValue && aValue >= -kLongLimit && aValue < kLongLimit)
+            return ModelNode::makeInteger(static_cast<long>(aValue));
+        return ModelNode::makeReal(aValue);
+    }
+
+    //one tape entry as a node; containers are left for expand()
+    ModelNode decodeEntry(const ModelNode::LazySource *aSource, ParseTape::Index anIndex) {
+        const ParseTape &theTape = *aSource->tape;
+        const ParseTape::Entry &theEntry = theTape[anIndex];
+        switch (theEntry.kind) {
+            case ParseTape::Kind::string:  return ModelNode::makeString(theTape.getText(theEntry.string), *aSource->arena);
+            case ParseTape::Kind::integer: return ModelNode::makeInteger(static_cast<long>(theEntry.integer));
+            case ParseTape::Kind::real:    return ModelNode::makeNumber(theEntry.real);
+            case ParseTape::Kind::boolean: return ModelNode::makeBool(theEntry.boolean);
+            case ParseTape::Kind::null:    return ModelNode();
+            default:                       return ModelNode::makeDeferred(aSource, anIndex);
+        }
+    }
+
+    void ModelNode::expand() const {
+        if (Type::deferred != type)
+            return;
+
+        const auto *theSource = load<const LazySource*>();
+        const ParseTape &theTape = *theSource->tape;
+        Arena &theArena = *theSource->arena;
+        const ParseTape::Index theIndex = load<ParseTape::Index>(kSizeOffset);
+        const ParseTape::Index theEnd = theTape.getNext(theIndex);
+
+        std::vector<Member> theMembers;
+        for (auto i = theIndex + 1; i < theEnd; i = theTape.getNext(i))
+            theMembers.push_back({makeString(theTape.getText(theTape[i].key), theArena), decodeEntry(theSource, i)});
+
+        if (ParseTape::Kind::array == theTape[theIndex].kind) {
+            std::vector<ModelNode> theItems;
+            theItems.reserve(theMembers.size());
+            for (const auto &theMember : theMembers)
+                theItems.push_back(theMember.value);
+            replaceWith(makeList(theItems.data(), theItems.size(), theArena));
+        }
+        else
+            replaceWith(makeObject(theMembers.data(), theMembers.data() + theMembers.size(), theArena, theSource->keyOrder));
+    }
+
+    //figure out what type the value is and make a node of that type
+    ModelNode Model::makeNode(std::string_view aValue, JSONProc::Element aType) {
         switch(aType){
             case Element::quoted:
-                (*temp).value = aValue;
-                break;
-            case Element::constant:
-                if(aValue == "true") {
-                    (*temp).value = true;
-                    break;
-
-                }
-                if(aValue == "false") {
-                    (*temp).value = false;
-                    break;
-                }
-                if(aValue == "null") {
-                    (*temp).value = ModelNode::NullType{};
-                    break;
-                }
-                if (std::fabs(std::stod(aValue) - std::trunc(std::stod(aValue)))>0){ //check if there is a remainder after truncation -> if yes, its a double
-                    (*temp).value = std::stod(aValue);
-                    break;
-                   }
-                else {
-                    (*temp).value = std::stol(aValue);
-                    break;
-                }
+                return ModelNode::makeString(aValue, getArena());
+            case Element::constant: {
+                const JSONConstant theConstant = JSONConstant::parse(aValue);
+                if (JSONConstant::Kind::integer == theConstant.kind)
+                    return ModelNode::makeInteger(static_cast<long>(theConstant.integer));
+                if (JSONConstant::Kind::real == theConstant.kind)
+                    return ModelNode::makeNumber(theConstant.real);
+                if (JSONConstant::Kind::boolean == theConstant.kind)
+                    return ModelNode::makeBool(theConstant.boolean);
+                return ModelNode();
+            }
             case Element::object:
-                (*temp).value = ModelNode::ObjectType {};
-                break;
+                return ModelNode(ModelNode::Type::object);
             case Element::array:
-                (*temp).value = ModelNode::ListType {};
-                break;
+                return ModelNode(ModelNode::Type::list);
             case Element::closing:
             case Element::unknown:
-                if(aValue.empty()) {
-                    break;
-                }
+                break;
         }
+        return ModelNode();
     }
 
-	bool Model::addKeyValuePair(const std::string& aKey, const std::string& aValue, Element aType) { //no need to error check because current
-        ModelNode* temp = new ModelNode;
+    //a finished child of the innermost open container; aKey is only used inside objects
+    bool Model::addNode(std::string_view aKey, const ModelNode& aNode) {
+        if (nodetracker.empty() || aKey.size() > ModelNode::kMaxSize)
+            return false;
+        pending.push_back({nodetracker.back().isList ? ModelNode() : ModelNode::makeString(aKey, getArena()), aNode});
+        return true;
+    }
 
-        populateNode(temp, aValue, aType);
+	bool Model::addKeyValuePair(std::string_view aKey, std::string_view aValue, Element aType, bool) { //no need to error check because current
+        if (tape)
+            return Element::quoted == aType ? tape->addString(aKey, aValue) : tape->addConstant(aKey, aValue);
 
-        ModelNode &aNode = *(nodetracker.top());
-        if (std::holds_alternative<ModelNode::ObjectType>(aNode.value)) {
-            auto& objMap = std::get<ModelNode::ObjectType>(aNode.value);
-            objMap.insert(std::make_pair(aKey, temp));
-            return true;
-        }
-        return false;
+        if (aValue.size() > ModelNode::kMaxSize)
+            return false;
+        return addNode(aKey, makeNode(aValue, aType));
 	}
 
-	bool Model::addItem(const std::string& aValue, Element aType) {
-        ModelNode* temp = new ModelNode;
-        populateNode(temp, aValue, aType);
-        ModelNode &aNode = *(nodetracker.top());
-        if (std::holds_alternative<ModelNode::ListType >(aNode.value)) {
-            auto &objList = std::get<ModelNode::ListType>(aNode.value);
-            objList.push_back(temp);
-            return true;
-        }
-        else {
-            aNode.value = ModelNode::ListType{new ModelNode{(*temp).value}};
-            return true;
-        }
-	}
+	bool Model::addItem(std::string_view aValue, Element aType, bool) {
+        if (tape)
+            return Element::quoted == aType ? tape->addString({}, aValue) : tape->addConstant({}, aValue);
 
-	bool Model::openContainer(const std::string& aContainerName, Element aType) {
+        if (aValue.size() > ModelNode::kMaxSize)
+            return false;
+        return addNode({}, makeNode(aValue, aType));
+	}
 
-        if (nodetracker.empty()) { //is this correct?
-            nodetracker.push(&rootNode);
-            return true;
-        }
+    bool Model::addInteger(std::string_view aKey, std::int64_t aValue) {
+        if (tape)
+            return tape->addInteger(aKey, aValue);
+        return addNode(aKey, ModelNode::makeInteger(static_cast<long>(aValue)));
+    }
 
-		ModelNode &temp = *(nodetracker.top()); //used to see if we should add item or add key-value pair
-        ModelNode* newNode = new ModelNode {};
+    bool Model::addDouble(std::string_view aKey, double aValue) {
+        if (tape)
+            return tape->addReal(aKey, aValue);
+        return addNode(aKey, ModelNode::makeNumber(aValue));
+    }
 
-        if(aType == Element::array) {
-            (*newNode).value = ModelNode::ListType{};
-        }
+    bool Model::addBool(std::string_view aKey, bool aValue) {
+        if (tape)
+            return tape->addBool(aKey, aValue);
+        return addNode(aKey, ModelNode::makeBool(aValue));
+    }
 
-        if (std::holds_alternative<ModelNode::ObjectType>(temp.value)) {
-            auto& objMap = std::get<ModelNode::ObjectType>(temp.value);
-            objMap.insert(std::make_pair(aContainerName, newNode));
-            nodetracker.push(newNode);
-            return true;
+    bool Model::addNull(std::string_view aKey) {
+        if (tape)
+            return tape->addNull(aKey);
+        return addNode(aKey, ModelNode());
+    }
 
+	bool Model::openContainer(std::string_view aContainerName, Element aType) {
+        if (tape) {
+            const bool isRoot = 0 == tape->size();
+            if (isRoot)
+                rootNode = ModelNode::makeDeferred(getArena().create<ModelNode::LazySource>(ModelNode::LazySource{tape.get(), &getArena(), keyOrder}), 0);
+            return tape->openContainer(aContainerName, aType);
         }
 
-        if (std::holds_alternative<ModelNode::ListType>(temp.value)) {
-            auto &objList = std::get<ModelNode::ListType>(temp.value);
-            objList.push_back(newNode);
-            nodetracker.push(newNode);
-            return true;
-        }
-        return false;
+        //the container's key waits with it until it closes
+        const bool isMember = !nodetracker.empty() && !nodetracker.back().isList;
+        if (isMember && aContainerName.size() > ModelNode::kMaxSize)
+            return false;
+        nodetracker.push_back({isMember ? ModelNode::makeString(aContainerName, getArena()) : ModelNode(),
+                               pending.size(), Element::array == aType});
+        return true;
 	}
 
-	bool Model::closeContainer([[maybe_unused]] const std::string& aContainerName, [[maybe_unused]] Element aType) {
-        //regardless of the name or type the process is the same
+	bool Model::closeContainer([[maybe_unused]] std::string_view aContainerName, [[maybe_unused]] Element aType) {
+        if (tape)
+            return tape->closeContainer();
 
-        if (!nodetracker.empty()) {
-            nodetracker.pop(); // Safe to pop if the stack is not empty
-            return true;
-        } else {
+        if (nodetracker.empty()) {
             std::cout << "nodetracker is empty, cannot pop!" << std::endl; //for debugging
             return false;
         }
 
+        //the children are final now, so they move into one contiguous block
+        const OpenContainer theContainer = nodetracker.back();
+        if (pending.size() - theContainer.start > ModelNode::kMaxSize)
+            return false; //more children than a node can count
+        nodetracker.pop_back();
+        ModelNode theNode;
+        if (theContainer.isList) {
+            items.clear();
+            for (size_t i = theContainer.start; i < pending.size(); ++i)
+                items.push_back(pending[i].value);
+            theNode = ModelNode::makeList(items.data(), items.size(), getArena());
+        }
+        else
+            theNode = ModelNode::makeObject(pending.data() + theContainer.start, pending.data() + pending.size(), getArena(), keyOrder);
+        pending.resize(theContainer.start);
+
+        if (nodetracker.empty())
+            rootNode = theNode;
+        else
+            pending.push_back({theContainer.key, theNode});
+        return true;
 	}
 
     // ---------------ModelQuery Class----------------
 
     //used to query the model
-	ModelQuery::ModelQuery(Model &aModel) : model(aModel) {
+    //getRoot() expands a lazy root in the Model, so every query shares its members
+	ModelQuery::ModelQuery(Model &aModel)
+        : arena(aModel.shareArena()), tape(aModel.tape), expansion(aModel.expansion), root(aModel.getRoot()) {
         calledByGet = false;
         errorChecking = false;
     }
@@ -165,60 +431,140 @@ namespace JSONProc {
     //-----select command-----
 
     ModelQuery& ModelQuery::select(const std::string& aQuery) {
-        if(aQuery=="") { //just for empty query
-            ModelNode *temp = &(this->model.getRoot());
-            this->tempModel.setRoot(*(temp));
+        return select(QueryPath(aQuery));
+    }
+
+    ModelQuery& ModelQuery::select(const QueryPath& aPath) {
+        const auto theLock = lockExpansion();
+        if(aPath.empty()) { //just for empty query
+            this->current = this->root;
             return *this;
         }
 
-        if (calledByGet) { //need this if statement just because I want to use the temp model instead of the root model
-            ModelNode* rootNode = &(this->tempModel.getRoot());
-            ModelNode* temp = traverseQuery(rootNode, aQuery); //get a pointer to the node that you want
-            if (temp) {
-                this->tempModel.setRoot(*(temp));
-                return *this;
-            }
-            else {
-                this->raiseErrorFlag(); //node that was queried doesn't exist
-                return *this;
-            }
+        //get() selects from the current node rather than the root
+        ModelNode *rootNode = calledByGet ? &this->current : &this->root;
+        if (!calledByGet)
+            errorChecking = false; //a new query, so an earlier query's failure doesn't carry over
+        if (aPath.selectsSet()) {
+            traverseSet(rootNode, aPath);
+            return *this;
+        }
+        ModelNode *temp = traverseQuery(rootNode, aPath); //get a pointer to the node that you want
+        if (temp) {
+            temp->expand(); //in place, so later queries find it decoded
+            this->current = *temp;
         }
         else {
-            ModelNode *rootNode = &(this->model.getRoot());
-            ModelNode *temp = traverseQuery(rootNode, aQuery); //get a pointer to the node that you want
-            if (temp) {
-                this->tempModel.setRoot(*(temp));
-                return *this;
-            } else {
-                this->raiseErrorFlag(); //node that was queried doesn't exist
-                return *this;
-            }
+            this->raiseErrorFlag(); //node that was queried doesn't exist
+            if (!calledByGet)
+                this->current = ModelNode(ModelNode::Type::object); //so consumers see nothing, not the last selection
         }
+        return *this;
 	}
 
+    ModelQuery& ModelQuery::selectEach(const std::vector<const QueryPath*>& aPaths, const std::function<void(size_t)>& aVisit) {
+        const auto theLock = lockExpansion();
+        //the paths' steps as a trie; each node's children and the paths ending there are lists
+        //threaded through pathNodes and pathEnds, which later batches reuse
+        pathNodes.assign(1, PathNode{nullptr, kNoPathNode, kNoPathNode, kNoPathNode});
+        pathEnds.assign(aPaths.size(), kNoPathNode);
+        for (size_t i = 0; i < aPaths.size(); ++i) {
+            if (aPaths[i]->selectsSet())
+                continue;
+            size_t theNode = 0;
+            for (const auto &theStep : aPaths[i]->getSteps()) {
+                size_t theChild = pathNodes[theNode].firstChild;
+                while (theChild != kNoPathNode && pathNodes[theChild].step->key != theStep.key)
+                    theChild = pathNodes[theChild].nextSibling;
+                if (theChild == kNoPathNode) {
+                    theChild = pathNodes.size();
+                    pathNodes.push_back({&theStep, kNoPathNode, pathNodes[theNode].firstChild, kNoPathNode});
+                    pathNodes[theNode].firstChild = theChild;
+                }
+                theNode = theChild;
+            }
+            pathEnds[i] = pathNodes[theNode].firstEnd;
+            pathNodes[theNode].firstEnd = i;
+        }
+
+        //each path's query starts clean, whatever the last one's consumer left set
+        const auto startQuery = [this]() {
+            this->aFilter.clearFilter();
+            calledByGet = false;
+            errorChecking = false;
+        };
+
+        //one walk, depth first; below a step the Model lacks, paths select alone to report it
+        std::vector<std::pair<size_t, ModelNode*>> theWalk{{0, &this->root}};
+        while (!theWalk.empty()) {
+            const auto [theIndex, theModelNode] = theWalk.back();
+            theWalk.pop_back();
+            if (theModelNode)
+                theModelNode->expand();
+            for (size_t thePath = pathNodes[theIndex].firstEnd; thePath != kNoPathNode; thePath = pathEnds[thePath]) {
+                startQuery();
+                if (theModelNode)
+                    this->current = *theModelNode;
+                else
+                    select(*aPaths[thePath]);
+                aVisit(thePath);
+            }
+
+            for (size_t theChild = pathNodes[theIndex].firstChild; theChild != kNoPathNode; theChild = pathNodes[theChild].nextSibling) {
+                const QueryPath::Step &theStep = *pathNodes[theChild].step;
+                ModelNode *theNext = nullptr;
+                if (theModelNode && ModelNode::Type::list == theModelNode->getType())
+                    theNext = theStep.isNumber && theStep.index < theModelNode->size() ? &theModelNode->getItems()[theStep.index] : nullptr;
+                else if (theModelNode && ModelNode::Type::object == theModelNode->getType())
+                    theNext = theModelNode->find(theStep.key);
+                theWalk.emplace_back(theChild, theNext);
+            }
+        }
+
+        for (size_t i = 0; i < aPaths.size(); ++i)
+            if (aPaths[i]->selectsSet()) {
+                startQuery();
+                select(*aPaths[i]);
+                aVisit(i);
+            }
+        return *this;
+    }
+
     // ---- filter command --------
     ModelQuery& ModelQuery::filter(const std::string& aQuery) {
+        return filter(filterPolicy(aQuery));
+    }
 
-        filterType aFilterType = determineFilterType(aQuery);
-        if (aFilterType == filterType::keyNameFilter) {
-            filterPolicy aFilterPolicy (extractCondition(aQuery), aFilterType);
-            std::string anOperation = "LocateSubstring";
-            aFilterPolicy.setOp(anOperation);
-            this->aFilter = aFilterPolicy;
-            return *this;
-        }
-        else if (aFilterType == filterType::indexFilter) {
-            filterPolicy aFilterPolicy (extractNumber(aQuery), aFilterType);
-            std::string anOperation = (extractOperation(aQuery));
-            aFilterPolicy.setOp(anOperation);
-            this->aFilter = aFilterPolicy;
-            return *this;
+    ModelQuery& ModelQuery::filter(const filterPolicy& aPolicy) {
+        this->aFilter = aPolicy;
+        return *this;
+    }
 
+    //calls aVisit with each element of aContainer in [aBegin, anEnd) that aFilter admits; a list's
+    //elements come from aCandidates, the filter's index ranges for it
+    template <typename Visit>
+    void visitAdmitted(const filterPolicy &aFilter, const ModelNode &aContainer, const IndexRanges &aCandidates,
+                       size_t aBegin, size_t anEnd, Visit aVisit) {
+        if (ModelNode::Type::list == aContainer.getType()) {
+            const bool isExact = aFilter.isExact();
+            for (const auto &theRange : aCandidates.getRanges())
+                for (size_t i = std::max(theRange.begin, aBegin); i < std::min(theRange.end, anEnd); i++)
+                    if (isExact || aFilter.isAdmittable(i, aContainer.getItems()[i]))
+                        aVisit(aContainer.getItems()[i], nullptr);
         }
-        else {
-            return *this; // just so warning will go away, it will never hit this
+        else if (ModelNode::Type::object == aContainer.getType()) {
+            for (size_t i = aBegin; i < anEnd; i++) {
+                const auto &theMember = aContainer.getMembers()[i];
+                if (aFilter.isAdmittable(theMember.key.getString(), theMember.value))
+                    aVisit(theMember.value, &theMember);
+            }
         }
+    }
 
+    template <typename Visit>
+    void visitAdmitted(const filterPolicy &aFilter, const ModelNode &aContainer, Visit aVisit) {
+        const IndexRanges theCandidates = ModelNode::Type::list == aContainer.getType() ? aFilter.getIndexRanges(aContainer.size()) : IndexRanges();
+        visitAdmitted(aFilter, aContainer, theCandidates, 0, aContainer.size(), aVisit);
     }
 
     //---------------Consuming methods ------------------------
@@ -229,38 +575,24 @@ namespace JSONProc {
     */
 
     size_t ModelQuery::count() {
-        struct GetCount {
-            GetCount(ModelQuery& modelQuery) : modelQuery(modelQuery) {}
-            size_t operator()(const ModelNode::NullType) const {return 0;}
-            size_t operator()(const bool&) const {return 0;}
-            size_t operator()(const long&) const {return 0;}
-            size_t operator()(const double&) const {return 0;}
-            size_t operator()(const std::string&) const {return 0;}
-            size_t operator()(const ModelNode::ListType &list) const {
-                size_t result{0};
-                for (size_t i =0; i<list.size(); i++)
-                    if (this->modelQuery.aFilter.isAdmittable(i)) {
-                        result++;
-                    }
-
-                return result;
-            }
-            size_t operator()(const ModelNode::ObjectType aMap) const {
-                size_t result{0};
-                for (const auto& pair : aMap) {
-                    if (this->modelQuery.aFilter.isAdmittable(pair.first)) {
-                        result++;
-                    }
-                }
-
-                return result;
-            }
-        private:
-            ModelQuery& modelQuery;
-        };
-        ModelNode temp;
-        temp.value = this->tempModel.getRoot().value;
-        size_t result = std::visit(GetCount(*this), temp.value);
+        const auto theLock = lockExpansion();
+        const ModelNode &temp = this->current;
+        size_t result{0};
+        if (ModelNode::Type::list == temp.getType() && this->aFilter.isExact())
+            result = this->aFilter.getIndexRanges(temp.size()).count(); //no element needs a look
+        else if (ModelNode::Type::list == temp.getType() || ModelNode::Type::object == temp.getType()) {
+            const IndexRanges theCandidates = this->aFilter.getIndexRanges(temp.size());
+            std::vector<size_t> theCounts(getBlockCount(temp.size()));
+            runBlocks(temp.size(), [&](size_t aBlock, std::vector<double>&) {
+                size_t theCount = 0;
+                const size_t theBegin = aBlock * kReductionBlock;
+                visitAdmitted(this->aFilter, temp, theCandidates, theBegin, std::min(temp.size(), theBegin + kReductionBlock),
+                              [&theCount](const ModelNode&, const ModelNode::Member*) { theCount++; });
+                theCounts[aBlock] = theCount;
+            });
+            for (const size_t theCount : theCounts)
+                result += theCount;
+        }
         this->aFilter.clearFilter();
         return result;
     }
@@ -278,110 +610,61 @@ namespace JSONProc {
      * Rounds sum to two decimal places
      */
     double ModelQuery::sum() {
-        struct GetSum {
-            GetSum(ModelQuery& modelQuery) : modelQuery(modelQuery) {}
-            double operator()(ModelNode::NullType) const {return 0;}
-            double operator()([[maybe_unused]] bool &value) const {return 0;}
-            double operator()(const long &value) const {return static_cast<double>(value);}
-            double operator()(const double &value) const {return value;}
-            double operator()([[maybe_unused]] const std::string &value) const {return 0;}
-            double operator()(const ModelNode::ListType &list) const {
-                double sum{0.0};
-                for (size_t i=0; i<list.size(); i++ ) {
-                    if (this->modelQuery.aFilter.isAdmittable(i)) {
-                        auto temp = list[i]->value;
-                        if (std::holds_alternative<double>(temp)) {
-                            sum += std::get<double>(temp);
-                        } else if (std::holds_alternative<long>(temp)) {
-                            sum += static_cast<double>(std::get<long>(temp));
-                        }
-                    }
-                }
-                return sum;
-            }
-            double operator()(const ModelNode::ObjectType &aMap) const {
-                double sum{0.0};
-                for (const auto& [key, aNodePtr] : aMap) {
-                    if (this->modelQuery.aFilter.isAdmittable(key)) {
-                        auto temp = aNodePtr->value;
-                        if (std::holds_alternative<double>(temp)) {
-                            sum += std::get<double>(temp);
-                        } else if (std::holds_alternative<long>(temp)) {
-                            sum += static_cast<double>(std::get<long>(temp));
-                        }
-                    }
-                }
-                return sum;
-            }
-        private:
-            ModelQuery& modelQuery;
-        };
-        ModelNode temp;
-        temp.value = this->tempModel.getRoot().value;
-        double sum = std::visit(GetSum(*this), temp.value);
-        this->aFilter.clearFilter();
+        size_t theCount;
+        const double sum = reduceNumbers(Reduction::sum, theCount).value_or(0.0);
         return  (std::round(sum * 100.0) / 100.0); //round the sum to two decimal places
-
-
     }
 
-    std::optional<std::string> ModelQuery::get(const std::string& aKeyOrIndex) {
-        struct GetNewModel {
-            GetNewModel(ModelQuery& modelQuery) : modelQuery(modelQuery) {}
-            ModelNode* operator()(ModelNode::NullType) const {
-                ModelNode* temp = new ModelNode{ModelNode::NullType{}};
-                return temp;
-            }
-            ModelNode* operator()(const bool &value) const {
-                ModelNode* temp = new ModelNode{value};
-                return temp;
-            }
-            ModelNode* operator()(const long &value) const {
-                ModelNode* temp = new ModelNode{value};
-                return temp;
-            }
-            ModelNode* operator()(const double &value) const {
-                ModelNode* temp = new ModelNode{value};
-                return temp;
-            }
-            ModelNode* operator()(const std::string &value) const {
-                ModelNode* temp = new ModelNode{value};
-                return temp;
-            }
-            ModelNode* operator()( ModelNode::ListType &list) {
-                ModelNode* templist = new ModelNode;
-                (*templist).value = ModelNode::ListType{};
-                for (size_t i=0; i<list.size(); i++ ) {
-                    if (this->modelQuery.aFilter.isAdmittable(static_cast<size_t>(i))) {
-                        auto &objList = std::get<ModelNode::ListType>(templist->value);
-                        objList.push_back(list[i]);
-                    }
-                }
-                return templist;
+    /*Policy Decisions of these functions:
+     * like sum, they look at the long and double values among the admitted elements (or at a
+     * value node itself) and skip everything else
+     * with no such values there is nothing to report, so they return nullopt
+     * avg rounds to two decimal places, like sum
+     */
+    std::optional<double> ModelQuery::min() {
+        size_t theCount;
+        return reduceNumbers(Reduction::minimum, theCount);
+    }
 
-            }
-            ModelNode* operator()(ModelNode::ObjectType &aMap)  {
-                ModelNode* tempObj = new ModelNode;
-                for (const auto& [key, aNodePtr] : aMap) {
-                    if (this->modelQuery.aFilter.isAdmittable(key)) {
-                        auto& objMap = std::get<ModelNode::ObjectType>(tempObj->value);
-                        objMap.insert(std::make_pair(key, aNodePtr));
-                    }
-                }
+    std::optional<double> ModelQuery::max() {
+        size_t theCount;
+        return reduceNumbers(Reduction::maximum, theCount);
+    }
 
-                return tempObj;
-            }
-        private:
-            ModelQuery& modelQuery;
-        };
+    std::optional<double> ModelQuery::avg() {
+        size_t theCount;
+        const auto theSum = reduceNumbers(Reduction::sum, theCount);
+        if (!theSum)
+            return std::nullopt;
+        return std::round(*theSum / theCount * 100.0) / 100.0;
+    }
 
+    std::optional<std::string> ModelQuery::get(const std::string& aKeyOrIndex) {
+        const auto theLock = lockExpansion();
         if (aKeyOrIndex == "*") {
             calledByGet = true;
             if (!errorChecking) {
-                ModelNode* filteredTemp = std::visit(GetNewModel(*this), this->tempModel.getRoot().value);
+                //the filtered copy's children point into the model's arena; only the blocks are new
+                const ModelNode &theNode = this->current;
+                Arena theArena;
+                ModelNode filteredTemp = theNode;
+                if (ModelNode::Type::list == theNode.getType()) {
+                    std::vector<ModelNode> theItems;
+                    visitAdmitted(this->aFilter, theNode, [&theItems](const ModelNode &aValue, const ModelNode::Member*) {
+                        theItems.push_back(aValue);
+                    });
+                    filteredTemp = ModelNode::makeList(theItems.data(), theItems.size(), theArena);
+                }
+                else if (ModelNode::Type::object == theNode.getType()) {
+                    std::vector<ModelNode::Member> theMembers;
+                    visitAdmitted(this->aFilter, theNode, [&theMembers](const ModelNode&, const ModelNode::Member *aMember) {
+                        theMembers.push_back(*aMember);
+                    });
+                    filteredTemp = ModelNode::makeObject(theMembers.data(), theMembers.data() + theMembers.size(), theArena, theNode.getKeyOrder());
+                }
                 calledByGet = false;
                 this->aFilter.clearFilter();
-                return (*filteredTemp).toString();
+                return filteredTemp.toString();
             }
             else {
                 calledByGet=false;
@@ -390,90 +673,51 @@ namespace JSONProc {
                 return std::nullopt;
             }
 
-        } else {
-            calledByGet = true;
-
-            this->select(aKeyOrIndex);
-            if (!errorChecking) {
-                calledByGet = false;
-                this->aFilter.clearFilter();
-                return this->tempModel.getRoot().toString();
-            } else {
-                calledByGet = false;
-                errorChecking = false;
-                this->aFilter.clearFilter();
-                return std::nullopt;
-            }
         }
+        return get(QueryPath(aKeyOrIndex));
+    }
+
+    std::optional<std::string> ModelQuery::get(const QueryPath& aPath) {
+        const auto theLock = lockExpansion();
+        calledByGet = true;
 
+        this->select(aPath);
+        if (!errorChecking) {
+            calledByGet = false;
+            this->aFilter.clearFilter();
+            return this->current.toString();
+        } else {
+            calledByGet = false;
+            errorChecking = false;
+            this->aFilter.clearFilter();
+            return std::nullopt;
+        }
     }
 
 
 
     //-----------------Primitives for Model Query --------------------
 
-    std::string ModelQuery::removeApostrophes(const std::string& str) {
-        if (str.size() >= 2 && str.front() == '\'' && str.back() == '\'') {
-            return str.substr(1, str.size() - 2);
-        } else {
-            // If the string doesn't have apostrophes around it, return as is
-            return str;
-        }
-    }
-
-    ModelNode* ModelQuery::traverseQuery(ModelNode* root, const std::string& query) {
-        size_t pos = query.find(".");
-        if (pos == std::string::npos) {
-            auto current = removeApostrophes(query);
-            if (auto* listPtr = std::get_if<ModelNode::ListType>(&root->value)) {
-                try {
-                    size_t index = std::stoi(current);
-                    if (index < listPtr->size()) {
-                        return (*listPtr)[index];
-                    } else {
-                        std::cerr << "Index out of bounds in list!" << std::endl;
-                        return nullptr;
-                    }
-                } catch (const std::invalid_argument& e) {
+    //walks one step at a time; nothing is allocated, however deep the path
+    ModelNode* ModelQuery::traverseQuery(ModelNode* root, const QueryPath& aPath) {
+        const auto &theSteps = aPath.getSteps();
+        for (size_t i = 0; i < theSteps.size(); ++i) {
+            const QueryPath::Step &theStep = theSteps[i];
+            root->expand();
+            if (ModelNode::Type::list == root->getType()) {
+                if (!theStep.isNumber) {
                     std::cerr << "Invalid index in list!" << std::endl;
                     return nullptr;
                 }
-            } else if (auto* objectPtr = std::get_if<ModelNode::ObjectType>(&root->value)) {
-                auto it = objectPtr->find(current);
-                if (it != objectPtr->end()) {
-                    return it->second;
-                } else {
-                    std::cerr << "Object '" << query << "' not found!" << std::endl;
-                    return nullptr;
-                }
-            } else {
-                std::cerr << "Unsupported value type!" << std::endl;
-                return nullptr;
-            }
-        } else {
-            std::string current = removeApostrophes((query.substr(0, pos)));
-
-            std::string next = query.substr(pos + 1);
-
-            if (auto *listPtr = std::get_if<ModelNode::ListType>(&root->value)) {
-                try {
-                    size_t index = std::stoi(current);
-                    if (index < listPtr->size()) {
-                        return traverseQuery((*listPtr)[index], next);
-                    } else {
-                        std::cerr << "Index out of bounds in list!" << std::endl;
-                        return nullptr;
-                    }
-                } catch (const std::invalid_argument &e) {
-                    std::cerr << "Invalid index in list!" << std::endl;
+                if (theStep.index >= root->size()) {
+                    std::cerr << "Index out of bounds in list!" << std::endl;
                     return nullptr;
                 }
-            } else if (auto *objectPtr = std::get_if<ModelNode::ObjectType>(&root->value)) {
-                auto it = objectPtr->find(current);
-                if (it != objectPtr->end()) {
-                    return traverseQuery(it->second, next);
-                } else {
-                    std::cerr << "Object '" << current << "' not found!" << std::endl;
+                root = &root->getItems()[theStep.index];
+            } else if (ModelNode::Type::object == root->getType()) {
+                root = root->find(theStep.key);
+                if (!root) {
+                    std::cerr << "Object '" << theStep.key << "' not found!" << std::endl;
                     return nullptr;
                 }
             } else {
@@ -481,114 +725,216 @@ namespace JSONProc {
                 return nullptr;
             }
         }
+        return root;
     }
 
-    void ModelQuery::raiseErrorFlag() {
-        errorChecking = true;
-    }
+    //adds the nodes one step of a set path reaches from aNode, in document order
+    void addStepNodes(const QueryPath::Step &aStep, ModelNode *aNode, std::vector<ModelNode*> &anOutput, bool mayFork);
 
-    //-------------filter command primitives-----------
+    //adds the nodes aStep reaches from each of aNodes, in order; big steps split across threads
+    void addStepNodes(const QueryPath::Step &aStep, ModelNode *const *aNodes, size_t aCount,
+                      std::vector<ModelNode*> &anOutput, bool mayFork) {
+        if (!mayFork || aCount < ModelQuery::kParallelFanOut || ThreadPool::getShared().size() < 2) {
+            for (size_t i = 0; i < aCount; ++i)
+                addStepNodes(aStep, aNodes[i], anOutput, mayFork);
+            return;
+        }
 
-    filterType ModelQuery::determineFilterType(const std::string& aQuery){
-        if (std::string::npos != aQuery.find("index")) {
-            return filterType::indexFilter;
+        //each thread walks a contiguous run of the nodes; joining the runs keeps document order
+        const size_t theThreads = std::min(ThreadPool::getShared().size(), aCount / (ModelQuery::kParallelFanOut / 4));
+        std::vector<std::vector<ModelNode*>> theParts(theThreads);
+        ThreadPool::getShared().parallelFor(theThreads, [&](size_t aPart) {
+            for (size_t i = aCount * aPart / theThreads; i < aCount * (aPart + 1) / theThreads; ++i)
+                addStepNodes(aStep, aNodes[i], theParts[aPart], false);
+        });
+        for (const auto &thePart : theParts)
+            anOutput.insert(anOutput.end(), thePart.begin(), thePart.end());
+    }
+
+    void addStepNodes(const QueryPath::Step &aStep, ModelNode *aNode, std::vector<ModelNode*> &anOutput, bool mayFork) {
+        aNode->expand();
+        const bool isList = ModelNode::Type::list == aNode->getType();
+        const bool isObject = ModelNode::Type::object == aNode->getType();
+        if (QueryPath::Kind::child == aStep.kind) {
+            ModelNode *theChild = nullptr;
+            if (isList && aStep.index < aNode->size())
+                theChild = &aNode->getItems()[aStep.index];
+            else if (isObject)
+                theChild = aNode->find(aStep.key);
+            if (theChild)
+                anOutput.push_back(theChild); //a set skips the nodes that lack the step
+            return;
         }
 
-        if (std::string::npos != aQuery.find("contains")) {
-            return filterType::keyNameFilter;
+        if (QueryPath::Kind::descendants == aStep.kind)
+            anOutput.push_back(aNode);
+        if (!isList && !isObject)
+            return;
+
+        if (QueryPath::Kind::wildcard == aStep.kind || (mayFork && aNode->size() >= ModelQuery::kParallelFanOut)) {
+            std::vector<ModelNode*> theChildren;
+            std::vector<ModelNode*> &theTarget = QueryPath::Kind::wildcard == aStep.kind ? anOutput : theChildren;
+            for (size_t i = 0; i < aNode->size(); ++i)
+                theTarget.push_back(isList ? &aNode->getItems()[i] : &aNode->getMembers()[i].value);
+            if (QueryPath::Kind::descendants == aStep.kind)
+                addStepNodes(aStep, theChildren.data(), theChildren.size(), anOutput, mayFork);
+            return;
         }
-        return filterType::none; // just so warning will go away, it will never hit this
+        for (size_t i = 0; i < aNode->size(); ++i)
+            addStepNodes(aStep, isList ? &aNode->getItems()[i] : &aNode->getMembers()[i].value, anOutput, mayFork);
     }
 
-    std::string ModelQuery::extractCondition(const std::string& input_string) {
-        // Find the position of the first single quote
-        size_t start_pos = input_string.find('\'');
-        if (start_pos == std::string::npos) {
-            return ""; // No single quote found
+    //walks a path with * or .. steps breadth first, then lists the nodes it reached
+    void ModelQuery::traverseSet(ModelNode* root, const QueryPath& aPath) {
+        frontier.assign(1, root);
+        for (const auto &theStep : aPath.getSteps()) {
+            nextFrontier.clear();
+            addStepNodes(theStep, frontier.data(), frontier.size(), nextFrontier, nullptr == tape);
+            frontier.swap(nextFrontier);
+        }
+        if (frontier.size() > ModelNode::kMaxSize) { //more than a list node can count
+            this->raiseErrorFlag();
+            this->current = ModelNode(ModelNode::Type::object);
+            return;
         }
 
-        // Find the position of the second single quote
-        size_t end_pos = input_string.find('\'', start_pos + 1);
-        if (end_pos == std::string::npos) {
-            return ""; // No second single quote found
+        //root may be current, listing the last selection, so that stays until the copy is made
+        nextSelection.clear();
+        for (ModelNode *theNode : frontier) {
+            theNode->expand();
+            nextSelection.push_back(*theNode);
         }
+        selection.swap(nextSelection);
+        this->current = ModelNode::makeListView(selection.data(), selection.size());
+    }
 
-        // Extract the substring between the single quotes to get the filter condition
-        return input_string.substr(start_pos + 1, end_pos - start_pos - 1);
+    std::optional<double> toNumber(const ModelNode &aNode) {
+        if (ModelNode::Type::real == aNode.getType())
+            return aNode.getReal();
+        if (ModelNode::Type::integer == aNode.getType())
+            return static_cast<double>(aNode.getInteger());
+        return std::nullopt;
     }
-    int ModelQuery::extractNumber(const std::string& s) {
-        std::istringstream iss(s);
-        std::string word;
-        while (iss >> word) {
-            if (std::isdigit(word[0])) {
-                return std::stoi(word);
-            }
+
+    size_t ModelQuery::getBlockCount(size_t aSize) {
+        return (aSize + kReductionBlock - 1) / kReductionBlock;
+    }
+
+    //calls aBlock for each block of a aSize-long container, with a buffer to gather into;
+    //an eager Model's big containers spread their blocks over the shared pool
+    void ModelQuery::runBlocks(size_t aSize, const std::function<void(size_t, std::vector<double>&)>& aBlock) {
+        const size_t theBlocks = getBlockCount(aSize);
+        if (nullptr != tape || aSize < kParallelReduction || ThreadPool::getShared().size() < 2) {
+            for (size_t i = 0; i < theBlocks; ++i)
+                aBlock(i, numbers);
+            return;
         }
-        throw std::invalid_argument("No number found in the string.");
+
+        const size_t theTasks = std::min(ThreadPool::getShared().size(), theBlocks);
+        ThreadPool::getShared().parallelFor(theTasks, [&](size_t aTask) {
+            std::vector<double> theNumbers;
+            for (size_t i = theBlocks * aTask / theTasks; i < theBlocks * (aTask + 1) / theTasks; ++i)
+                aBlock(i, theNumbers);
+        });
     }
-    std::string ModelQuery::extractOperation(const std::string &aQuery) {
-        std::regex re("(==|!=|<=?|>=?)");
-        std::smatch match;
-        if (std::regex_search(aQuery, match, re)) {
-            return match.str();
+
+    //reduces the numbers among the admitted elements a block at a time, copying each block's
+    //into one contiguous run, then reduces the blocks' results in block order. The blocks are
+    //the same however many threads run them, so the result is too. Clears the filter.
+    std::optional<double> ModelQuery::reduceNumbers(Reduction aReduction, size_t &aCount) {
+        const auto theLock = lockExpansion();
+        auto reduce = [aReduction](const double *aValues, size_t aSize) {
+            if (Reduction::minimum == aReduction)
+                return NumberKernels::getMinimum(aValues, aSize);
+            if (Reduction::maximum == aReduction)
+                return NumberKernels::getMaximum(aValues, aSize);
+            return NumberKernels::sum(aValues, aSize);
+        };
+
+        const ModelNode &temp = this->current;
+        if (ModelNode::Type::list != temp.getType() && ModelNode::Type::object != temp.getType()) {
+            this->aFilter.clearFilter();
+            const auto theNumber = toNumber(temp);
+            aCount = theNumber ? 1 : 0;
+            return theNumber;
         }
-        return "";
+
+        const IndexRanges theCandidates = this->aFilter.getIndexRanges(temp.size());
+        std::vector<double> theResults(getBlockCount(temp.size()));
+        std::vector<size_t> theCounts(theResults.size());
+        runBlocks(temp.size(), [&](size_t aBlock, std::vector<double> &aNumbers) {
+            aNumbers.clear();
+            const size_t theBegin = aBlock * kReductionBlock;
+            visitAdmitted(this->aFilter, temp, theCandidates, theBegin, std::min(temp.size(), theBegin + kReductionBlock),
+                          [&aNumbers](const ModelNode &aValue, const ModelNode::Member*) {
+                              if (const auto theNumber = toNumber(aValue))
+                                  aNumbers.push_back(*theNumber);
+                          });
+            theCounts[aBlock] = aNumbers.size();
+            if (!aNumbers.empty())
+                theResults[aBlock] = reduce(aNumbers.data(), aNumbers.size());
+        });
+        this->aFilter.clearFilter();
+
+        size_t theReduced = 0;
+        aCount = 0;
+        for (size_t i = 0; i < theResults.size(); ++i) {
+            if (theCounts[i])
+                theResults[theReduced++] = theResults[i];
+            aCount += theCounts[i];
+        }
+        if (!theReduced)
+            return std::nullopt;
+        return reduce(theResults.data(), theReduced);
+    }
+
+    std::unique_lock<std::recursive_mutex> ModelQuery::lockExpansion() const {
+        return expansion ? std::unique_lock<std::recursive_mutex>(*expansion) : std::unique_lock<std::recursive_mutex>();
     }
 
+    void ModelQuery::raiseErrorFlag() {
+        errorChecking = true;
+    }
 
     //-------------filter policy class primitives ---------------
 
-    filterPolicy::filterPolicy(std::variant<std::string, int> _filterCondition, JSONProc::filterType _aFilterType) {
-        this->filterCondition = _filterCondition;
-        this->aFilterType = _aFilterType;
-    }
-    void filterPolicy::setOp (std::string &_anOperation) {
-        this->anOperation = _anOperation;
+    filterPolicy::filterPolicy(const std::string &aCondition)
+        : expression(FilterExpression::parse(aCondition)), isValid(expression != nullptr) {}
+
+    Comparison filterPolicy::getComparison(const std::string &anOperation) {
+        static const std::map<std::string, Comparison> kComparisons = {
+                {"==", Comparison::equal},
+                {"!=", Comparison::notEqual},
+                {"<", Comparison::less},
+                {"<=", Comparison::lessEqual},
+                {">", Comparison::greater},
+                {">=", Comparison::greaterEqual},
+        };
+        const auto theComparison = kComparisons.find(anOperation);
+        return theComparison != kComparisons.end() ? theComparison->second : Comparison::invalid;
     }
     void filterPolicy::clearFilter() {
-        this->aFilterType = filterType::none;
-    }
-    bool filterPolicy::compare(int a, int b, std::function<bool(int, int)> op) {
-        return op(a, b);
+        this->expression.reset();
+        this->isValid = true;
     }
 
     //determines if a node is allowed through the filter or not
-    bool filterPolicy::isAdmittable(std::variant<std::string, size_t> currentPosition) {
-        if (this->aFilterType == filterType::indexFilter) {
-
-            std::map<std::string, std::function<bool(int, int)>> ops = {
-                    {"==", [](int a, int b) { return a == b; }},
-                    {"!=", [](int a, int b) { return a != b; }},
-                    {"<", [](int a, int b) { return a < b; }},
-                    {">", [](int a, int b) { return a > b; }},
-                    {"<=", [](int a, int b) { return a <= b; }},
-                    {">=", [](int a, int b) { return a >= b; }},
-            };
-
-            bool result = compare(std::get<size_t>(currentPosition), std::get<int>(filterCondition), ops[anOperation]);
-            return result;
+    bool filterPolicy::isAdmittable(size_t anIndex, const ModelNode &aValue) const {
+        return expression ? expression->matches({anIndex, {}, aValue, false}) : isValid;
+    }
 
-            
-        }
+    bool filterPolicy::isAdmittable(std::string_view aKey, const ModelNode &aValue) const {
+        return expression ? expression->matches({0, aKey, aValue, true}) : isValid;
+    }
 
-        if (this->aFilterType == filterType::keyNameFilter) {
-            std::string current = std::get<std::string>(currentPosition);
-            std::string filter = std::get<std::string>(filterCondition);
-            if (std::string::npos == current.find(filter)) {
-                return false;
-            }
-            else {
-                return true;
-            }
-        }
+    IndexRanges filterPolicy::getIndexRanges(size_t aSize) const {
+        if (expression)
+            return expression->getCandidates(aSize);
+        return isValid ? IndexRanges::getAll(aSize) : IndexRanges();
+    }
 
-        if (this->aFilterType == filterType::none) {
-            return true;
-        }
-        return false; // just so warning will go away, it will never hit this
+    bool filterPolicy::isExact() const {
+        return expression ? expression->isExact() : true;
     }
 
 }
-
-
-
@@ -6,152 +6,296 @@
 
 #include <string>
 #include <optional>
+#include "Arena.h"
 #include "JSONParser.h"
+#include "ParseTape.h"
+#include "QueryPath.h"
 #include <variant>
 #include <vector>
 #include <map>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <stack>
 #include <utility>
 #include "Formatting.h"
-#include <regex>
+#include "IndexRanges.h"
+#include "FilterExpression.h"
 #include <cmath>
 
 namespace JSONProc {
 
 	class ModelQuery;
     class filterPolicy;
-    enum class filterType;
+
+    // How an object keeps its members: sorted by key, as Models always have, or in the order
+    // the document wrote them
+    enum class KeyOrder : std::uint8_t { sorted, document };
 
 	// Model is built from a bunch of these...
+	// Each is 16 bytes: a type tag and either a scalar, a string (inline when it's short) or a
+	// container's size and its contiguous children. Everything they point to lives in an Arena.
 	struct ModelNode {
+        enum class Type : std::uint8_t { null, integer, real, boolean, string, list, object, deferred };
+
+        struct Member;
+        // Where a lazy Model's Deferred containers decode from
+        struct LazySource {
+            const ParseTape *tape;
+            Arena *arena;
+            KeyOrder keyOrder;
+        };
+
+        static constexpr size_t kInlineLength = 14;
+        static constexpr size_t kLinearScanLimit = 16; // wider document-order objects get a hash index
+        static constexpr size_t kMaxSize = std::numeric_limits<std::uint32_t>::max(); // the longest string, and most children, a node holds
+
+        ModelNode() = default; // null
+        explicit ModelNode(Type anEmptyType) : type(anEmptyType) {} // null, or an empty list or object
+        static ModelNode makeInteger(long aValue);
+        static ModelNode makeReal(double aValue);
+        static ModelNode makeNumber(double aValue); // an integer when aValue is a whole number
+        static ModelNode makeBool(bool aValue);
+        // Sizes past kMaxSize don't fit a node; callers fail the parse before they get here
+        static ModelNode makeString(std::string_view aValue, Arena &anArena);
+        static ModelNode makeList(const ModelNode *anItems, size_t aCount, Arena &anArena);
+        // A list over items the caller keeps alive, such as the nodes a query selected
+        static ModelNode makeListView(ModelNode *anItems, size_t aCount);
+        // Keeps the first of any repeated key; sorted objects also sort the members by key
+        static ModelNode makeObject(Member *aFirst, Member *aLast, Arena &anArena, KeyOrder anOrder = KeyOrder::sorted);
+        // A container of a lazy Model that no query has visited yet
+        static ModelNode makeDeferred(const LazySource *aSource, ParseTape::Index anIndex);
+
+        Type getType() const { return type; }
+        long getInteger() const { return load<long>(); }
+        double getReal() const { return load<double>(); }
+        bool getBool() const { return load<bool>(); }
+        std::string_view getString() const;
+
+        // Lists and objects
+        size_t size() const { return load<std::uint32_t>(kSizeOffset); }
+        ModelNode* getItems() const { return load<ModelNode*>(); }
+        Member* getMembers() const { return load<Member*>(); }
+        KeyOrder getKeyOrder() const { return static_cast<KeyOrder>(detail) == KeyOrder::document ? KeyOrder::document : KeyOrder::sorted; }
+        ModelNode* find(std::string_view aKey) const; // nullptr when there's no such member
+
+        // Decodes a Deferred container's members from its tape; nested containers stay Deferred
+        void expand() const;
+
+        [[nodiscard]] std::string toString() const;
 
-        using ListType = std::vector<ModelNode*>;
-        using ObjectType = std::map<std::string, ModelNode*>;
-        struct NullType {};
-        std::variant<NullType, long, double, bool, std::string, ListType, ObjectType> value = std::map<std::string, ModelNode*>();
-
-        [[nodiscard]] std::string toString() const {
-            struct StringVisitor {
-                std::string operator()(NullType) {return "null";}
-                std::string operator()(const bool &value) {return value ? "true" : "false";}
-                std::string operator()(const double &value) {return std::to_string(value);} //ask about behavior of trailing zeroes
-                std::string operator()(const long &value) {return  std::to_string(value);}
-                std::string operator()(const std::string &value) {return "\"" + value + "\"";}
-                std::string operator()(const ListType &list) {
-
-                    std::string output = "[";
-                    for (auto it = list.begin(); it != list.end(); ++it) {
-                        if (std::next(it) != list.end()) {
-                           output += (*it)->toString() + ", ";
-                        }
-                        else{
-                           return output += (*it)->toString() + "]";
-                        }
-                    }
-                    return output; // just so warning will go away, it will never hit this
-                }
-                std::string operator()(const ObjectType &object) {
-                    std::string output = "{";
-                    for (auto it = object.begin(); it != object.end(); ++it) {
-                        output += "\"" + it->first + "\": " + (*it->second).toString();
-                        if (std::next(it) != object.end()) {
-                            output += ", ";
-                        } else {
-                            return output + "}";
-                        }
-                    }
-                    return output; // just so warning will go away, it will never hit this
-                }
-            };
+        friend std::ostream& operator << (std::ostream &anOut, const ModelNode &aNode) { //for debugging purposes
+            return anOut << aNode.toString();
+        }
 
-           return std::visit(StringVisitor(), value);
+    protected:
+        static constexpr size_t kSizeOffset = 8;
+        static constexpr std::uint8_t kNotInline = 0xff;
+        static constexpr std::uint32_t kEmptySlot = 0xffffffff;
 
+        void replaceWith(const ModelNode &aNode) const {
+            std::memcpy(data, aNode.data, sizeof(data));
+            detail = aNode.detail;
+            type = aNode.type;
         }
 
-        friend std::ostream& operator << (std::ostream &anOut, const ModelNode &aNode) { //for debugging purposes
-            return anOut << aNode.toString();
+        // A wide document-order object's index follows its members: an open-addressed table
+        // of member positions, at most half full
+        static size_t getSlotCount(size_t aCount);
+        static std::uint32_t* findSlot(const Member *aMembers, std::uint32_t *aSlots, size_t aSlotCount, std::string_view aKey);
+
+        template <typename T>
+        T load(size_t anOffset = 0) const {
+            T theValue;
+            std::memcpy(&theValue, data + anOffset, sizeof(T));
+            return theValue;
+        }
+
+        template <typename T>
+        void store(T aValue, size_t anOffset = 0) const {
+            std::memcpy(data + anOffset, &aValue, sizeof(T));
         }
 
+        // mutable so even const readers can expand a Deferred node in place.
+        // [0, 8) holds the value or a pointer, [8, 12) a size; short strings use all of it.
+        alignas(8) mutable char data[kInlineLength] {};
+        mutable std::uint8_t detail = kNotInline; // a short string's length, or an object's KeyOrder
+        mutable Type type = Type::null;
 	};
 
-	class Model : public JSONListener {
+    struct ModelNode::Member {
+        ModelNode key; // always a string
+        ModelNode value;
+    };
+
+    static_assert(sizeof(ModelNode) == 16, "ModelNode should stay two words");
+
+    // eager builds every ModelNode while parsing; lazy records a ParseTape and builds
+    // a container's nodes when a query first visits it
+    enum class ModelMode { eager, lazy };
+
+	// final, so BasicJSONParser<Model> calls its callbacks directly
+	class Model final : public JSONViewListener {
         public:
             Model();
+            explicit Model(ModelMode aMode, KeyOrder anOrder = KeyOrder::sorted, std::shared_ptr<Arena> anArena = nullptr);
             Model(ModelNode &_rootNode);
             ~Model() override = default;
             Model(const Model& aModel);
             Model &operator=(const Model& aModel);
+            Model(Model&& aModel) = default;
+            Model &operator=(Model&& aModel) = default;
 
             ModelQuery createQuery();
 
-            bool addKeyValuePair(const std::string &aKey, const std::string &aValue, Element aType) override;
-            bool addItem(const std::string &aValue, Element aType) override;
-            bool openContainer(const std::string &aKey, Element aType) override;
-            bool closeContainer(const std::string &aKey, Element aType) override;
+            bool addKeyValuePair(std::string_view aKey, std::string_view aValue, Element aType, bool isEscaped) override;
+            bool addItem(std::string_view aValue, Element aType, bool isEscaped) override;
+            bool openContainer(std::string_view aKey, Element aType) override;
+            bool closeContainer(std::string_view aKey, Element aType) override;
+            bool addInteger(std::string_view aKey, std::int64_t aValue) override;
+            bool addDouble(std::string_view aKey, double aValue) override;
+            bool addBool(std::string_view aKey, bool aValue) override;
+            bool addNull(std::string_view aKey) override;
+            //a lazy Model's nodes expand as they're read, so only queries may read them from several threads
             ModelNode& getRoot();
             void setRoot(const ModelNode& newRootNode);
+            bool isLazy() const { return tape != nullptr; }
+            KeyOrder getKeyOrder() const { return keyOrder; }
+
+            //made on first use; share it with Models parsed on the same thread, or keep() it in
+            //another Model's arena when linking this Model's nodes into that one
+            Arena& getArena() {
+                if (!arena)
+                    arena = std::make_shared<Arena>();
+                return *arena;
+            }
+            std::shared_ptr<Arena> shareArena() {
+                getArena();
+                return arena;
+            }
 
 
 
         protected:
-            ModelNode rootNode;
-            std::stack<ModelNode*> nodetracker;
-            void populateNode(ModelNode* temp, const std::string &aValue, JSONProc::Element aType);
+            //a container being parsed; its members wait in pending from start on
+            struct OpenContainer {
+                ModelNode key;
+                size_t start;
+                bool isList;
+            };
 
+            std::shared_ptr<Arena> arena;
+            ModelNode rootNode{ModelNode::Type::object};
+            std::shared_ptr<ParseTape> tape; //lazy models only; shared by copies, whose nodes point into it
+            //lazy models only; expanding writes shared nodes and the arena, so copies and queries
+            //on any thread expand under it
+            std::shared_ptr<std::recursive_mutex> expansion;
+            KeyOrder keyOrder = KeyOrder::sorted;
+            std::vector<OpenContainer> nodetracker;
+            std::vector<ModelNode::Member> pending; //finished children of the open containers, in order
+            std::vector<ModelNode> items; //a closing list's children, reused from list to list
+            ModelNode makeNode(std::string_view aValue, JSONProc::Element aType);
+            bool addNode(std::string_view aKey, const ModelNode& aNode);
+
+            friend class ModelQuery;
 	};
 
-    enum class filterType{
-        indexFilter, keyNameFilter, none
-    };
-
-
     class filterPolicy {
         public:
-            filterPolicy() = default;
-            filterPolicy (std::variant<std::string, int> filterCondition, filterType _aFilterType);
-            bool isAdmittable (std::variant<std::string, size_t> currentPosition);
-            void setOp (std::string &_anOperation);
+            filterPolicy() = default; //admits everything
+            // compiles aCondition once; a condition that doesn't parse admits nothing
+            explicit filterPolicy (const std::string &aCondition);
+            // called for every element, so neither allocates
+            bool isAdmittable (size_t anIndex, const ModelNode &aValue) const;
+            bool isAdmittable (std::string_view aKey, const ModelNode &aValue) const;
+            // the indices of a aSize-long list that may be admitted; exactly those when isExact()
+            IndexRanges getIndexRanges (size_t aSize) const;
+            bool isExact () const;
+            static Comparison getComparison (const std::string &anOperation);
             void clearFilter();
 
         protected:
-            bool compare(int a, int b, std::function<bool(int, int)> op);
-            filterType aFilterType;
-            std::variant<std::string, int> filterCondition;
-            std::string anOperation;
+            std::shared_ptr<const FilterExpression> expression;
+            bool isValid = true;
     };
 
 	class ModelQuery {
 	public:
+		// a step of a * or .. path over this many nodes splits them across threads (eager Models only)
+		static constexpr size_t kParallelFanOut = 16384;
+		// count and the numeric consumers work in blocks of kReductionBlock elements, on the shared
+		// pool's threads once a container has kParallelReduction (eager Models only)
+		static constexpr size_t kReductionBlock = 16384;
+		static constexpr size_t kParallelReduction = 8 * kReductionBlock;
+
 		ModelQuery(Model& aModel);
+		// a selected set is a list over this query's own buffer, so a query moves but doesn't copy
+		ModelQuery(const ModelQuery&) = delete;
+		ModelQuery& operator=(const ModelQuery&) = delete;
+		ModelQuery(ModelQuery&&) = default;
+		ModelQuery& operator=(ModelQuery&&) = default;
 
 		// ---Traversal---
 		ModelQuery& select(const std::string& aQuery);
+		ModelQuery& select(const QueryPath& aPath); // decoded once, for paths that run again and again
+		// Selects each of aPaths in turn and calls aVisit with its position, in no set order. The
+		// paths are walked together, so a prefix that several share is looked up once.
+		ModelQuery& selectEach(const std::vector<const QueryPath*>& aPaths, const std::function<void(size_t)>& aVisit);
 
 		// ---Filtering---
 		ModelQuery& filter(const std::string& aQuery);
+		ModelQuery& filter(const filterPolicy& aPolicy); // compiled once, for filters that run again and again
 
 		// ---Consuming---
 		size_t count();// count number of nodes in a node
 		double sum();
+		std::optional<double> min(); // nullopt when there are no numbers
+		std::optional<double> max();
+		std::optional<double> avg();
 		std::optional<std::string> get(const std::string& aKeyOrIndex);
+		std::optional<std::string> get(const QueryPath& aPath);
 
 
 	protected:
         // --- data members ---
-		Model model;
-        Model tempModel;
+        // a query shares the memory the Model's nodes live in, so it can outlive the Model,
+        // but it copies no nodes: making one and selecting are O(1) in the document's size
+        std::shared_ptr<Arena> arena;
+        std::shared_ptr<const ParseTape> tape; //what a lazy Model's deferred nodes decode from
+        std::shared_ptr<std::recursive_mutex> expansion; //the lazy Model's; held by each query call
+        ModelNode root;
+        ModelNode current{ModelNode::Type::object}; //the selection; an empty object until select()
         filterPolicy aFilter;
+        std::vector<ModelNode> selection, nextSelection; //the nodes a * or .. path selected, which current lists
+        std::vector<ModelNode*> frontier, nextFrontier; //reused from select to select
+        std::vector<double> numbers; //a block's numbers, when the blocks run on this thread
+
+        // a node of selectEach's trie of paths
+        struct PathNode {
+            const QueryPath::Step *step;
+            size_t firstChild;
+            size_t nextSibling;
+            size_t firstEnd; //the first path that ends here; pathEnds holds the next
+        };
+        static constexpr size_t kNoPathNode = static_cast<size_t>(-1);
+        std::vector<PathNode> pathNodes;
+        std::vector<size_t> pathEnds;
         bool errorChecking;
         bool calledByGet;
 
         // --- primitives ----
-        std::string removeApostrophes(const std::string& str);
-        ModelNode* traverseQuery(ModelNode* root, const std::string& query);
+        ModelNode* traverseQuery(ModelNode* root, const QueryPath& aPath);
+        void traverseSet(ModelNode* root, const QueryPath& aPath);
+        enum class Reduction { sum, minimum, maximum };
+        static size_t getBlockCount(size_t aSize);
+        void runBlocks(size_t aSize, const std::function<void(size_t, std::vector<double>&)>& aBlock);
+        std::optional<double> reduceNumbers(Reduction aReduction, size_t &aCount);
         void raiseErrorFlag();
-        filterType determineFilterType(const std::string& aQuery);
-        std::string extractCondition(const std::string& input_string);
-        int extractNumber(const std::string& s);
-        std::string extractOperation(const std::string &aQuery);
+        // the expansion lock of a lazy Model, so queries on several threads take turns; none when eager
+        std::unique_lock<std::recursive_mutex> lockExpansion() const;
 
 	};
 
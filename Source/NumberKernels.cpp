@@ -0,0 +1,151 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "NumberKernels.h"
+#include <algorithm>
+#include <cmath>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define JSONPROC_X86_KERNELS 1
+    #include <immintrin.h>
+#endif
+
+namespace JSONProc {
+
+    // Both kernels give value i to lane i % kLanes, so they add in the same order and agree exactly
+    const size_t kLanes = 4;
+
+    // Adds aValue to aSum, and what that addition rounded away to aCompensation
+    inline void addCompensated(double &aSum, double &aCompensation, double aValue) {
+        const double theTotal = aSum + aValue;
+        aCompensation += std::fabs(aSum) >= std::fabs(aValue) ? (aSum - theTotal) + aValue : (aValue - theTotal) + aSum;
+        aSum = theTotal;
+    }
+
+    double combineLanes(double *aSums, double *aCompensations, const double *aRest, size_t aRestCount) {
+        for (size_t i = 0; i < aRestCount; ++i)
+            addCompensated(aSums[0], aCompensations[0], aRest[i]);
+
+        double theSum = 0.0, theCompensation = 0.0;
+        for (size_t theLane = 0; theLane < kLanes; ++theLane) {
+            addCompensated(theSum, theCompensation, aSums[theLane]);
+            theCompensation += aCompensations[theLane];
+        }
+        return theSum + theCompensation;
+    }
+
+    double sumScalar(const double *aValues, size_t aCount) {
+        double theSums[kLanes] = {}, theCompensations[kLanes] = {};
+        size_t i = 0;
+        for (; i + kLanes <= aCount; i += kLanes)
+            for (size_t theLane = 0; theLane < kLanes; ++theLane)
+                addCompensated(theSums[theLane], theCompensations[theLane], aValues[i + theLane]);
+        return combineLanes(theSums, theCompensations, aValues + i, aCount - i);
+    }
+
+    template <typename Pick>
+    double reduceScalar(const double *aValues, size_t aCount, Pick aPick) {
+        double theBest[kLanes] = {aValues[0], aValues[0], aValues[0], aValues[0]};
+        size_t i = 0;
+        for (; i + kLanes <= aCount; i += kLanes)
+            for (size_t theLane = 0; theLane < kLanes; ++theLane)
+                theBest[theLane] = aPick(theBest[theLane], aValues[i + theLane]);
+        for (; i < aCount; ++i)
+            theBest[0] = aPick(theBest[0], aValues[i]);
+        return aPick(aPick(theBest[0], theBest[1]), aPick(theBest[2], theBest[3]));
+    }
+
+#ifdef JSONPROC_X86_KERNELS
+
+    __attribute__((target("avx2")))
+    double sumAVX2(const double *aValues, size_t aCount) {
+        const __m256d theSignBits = _mm256_set1_pd(-0.0);
+        __m256d theSums = _mm256_setzero_pd(), theCompensations = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + kLanes <= aCount; i += kLanes) {
+            const __m256d theValues = _mm256_loadu_pd(aValues + i);
+            const __m256d theTotals = _mm256_add_pd(theSums, theValues);
+            const __m256d isSumLarger = _mm256_cmp_pd(_mm256_andnot_pd(theSignBits, theSums),
+                                                      _mm256_andnot_pd(theSignBits, theValues), _CMP_GE_OQ);
+            const __m256d theLarger = _mm256_blendv_pd(theValues, theSums, isSumLarger);
+            const __m256d theSmaller = _mm256_blendv_pd(theSums, theValues, isSumLarger);
+            theCompensations = _mm256_add_pd(theCompensations, _mm256_add_pd(_mm256_sub_pd(theLarger, theTotals), theSmaller));
+            theSums = theTotals;
+        }
+
+        double theLaneSums[kLanes], theLaneCompensations[kLanes];
+        _mm256_storeu_pd(theLaneSums, theSums);
+        _mm256_storeu_pd(theLaneCompensations, theCompensations);
+        return combineLanes(theLaneSums, theLaneCompensations, aValues + i, aCount - i);
+    }
+
+    template <bool isMinimum>
+    __attribute__((target("avx2")))
+    double reduceAVX2(const double *aValues, size_t aCount) {
+        auto thePick = [](double aLeft, double aRight) { return isMinimum ? std::min(aLeft, aRight) : std::max(aLeft, aRight); };
+        if (aCount < kLanes)
+            return reduceScalar(aValues, aCount, thePick);
+
+        __m256d theBest = _mm256_loadu_pd(aValues);
+        size_t i = kLanes;
+        for (; i + kLanes <= aCount; i += kLanes) {
+            const __m256d theValues = _mm256_loadu_pd(aValues + i);
+            theBest = isMinimum ? _mm256_min_pd(theBest, theValues) : _mm256_max_pd(theBest, theValues);
+        }
+
+        double theLanes[kLanes];
+        _mm256_storeu_pd(theLanes, theBest);
+        for (; i < aCount; ++i)
+            theLanes[0] = thePick(theLanes[0], aValues[i]);
+        return thePick(thePick(theLanes[0], theLanes[1]), thePick(theLanes[2], theLanes[3]));
+    }
+
+#endif
+
+    bool NumberKernels::isSupported(Kernel aKernel) {
+        switch (aKernel) {
+#ifdef JSONPROC_X86_KERNELS
+            case Kernel::avx2:
+                return __builtin_cpu_supports("avx2");
+#endif
+            case Kernel::scalar:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    NumberKernels::Kernel NumberKernels::getBestKernel() {
+        static const Kernel theBest = isSupported(Kernel::avx2) ? Kernel::avx2 : Kernel::scalar;
+        return theBest;
+    }
+
+    double NumberKernels::sum(const double *aValues, size_t aCount, Kernel aKernel) {
+#ifdef JSONPROC_X86_KERNELS
+        if (Kernel::avx2 == aKernel && isSupported(aKernel))
+            return sumAVX2(aValues, aCount);
+#endif
+        (void)aKernel;
+        return sumScalar(aValues, aCount);
+    }
+
+    double NumberKernels::getMinimum(const double *aValues, size_t aCount, Kernel aKernel) {
+#ifdef JSONPROC_X86_KERNELS
+        if (Kernel::avx2 == aKernel && isSupported(aKernel))
+            return reduceAVX2<true>(aValues, aCount);
+#endif
+        (void)aKernel;
+        return reduceScalar(aValues, aCount, [](double aLeft, double aRight) { return std::min(aLeft, aRight); });
+    }
+
+    double NumberKernels::getMaximum(const double *aValues, size_t aCount, Kernel aKernel) {
+#ifdef JSONPROC_X86_KERNELS
+        if (Kernel::avx2 == aKernel && isSupported(aKernel))
+            return reduceAVX2<false>(aValues, aCount);
+#endif
+        (void)aKernel;
+        return reduceScalar(aValues, aCount, [](double aLeft, double aRight) { return std::max(aLeft, aRight); });
+    }
+
+}
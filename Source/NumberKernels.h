@@ -0,0 +1,29 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include <cstddef>
+
+namespace JSONProc {
+
+    // Reductions over a contiguous run of doubles, which ModelQuery gathers the numbers of a
+    // list or object into. Sums are compensated (Neumaier) in independent lanes, so their error
+    // doesn't grow with the count; the AVX2 kernel runs four lanes at once and is picked at run
+    // time, as StructuralIndex picks its kernels.
+    class NumberKernels {
+    public:
+        enum class Kernel { scalar, avx2 };
+
+        static Kernel getBestKernel();
+        static bool isSupported(Kernel aKernel);
+
+        static double sum(const double *aValues, size_t aCount, Kernel aKernel = getBestKernel());
+
+        // aCount must not be 0
+        static double getMinimum(const double *aValues, size_t aCount, Kernel aKernel = getBestKernel());
+        static double getMaximum(const double *aValues, size_t aCount, Kernel aKernel = getBestKernel());
+    };
+
+}
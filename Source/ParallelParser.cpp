@@ -0,0 +1,272 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "ParallelParser.h"
+#include <algorithm>
+#include <memory>
+
+namespace JSONProc {
+
+    const size_t kMinChunkSize = 256 * 1024;
+    const size_t kChunksPerThread = 2;
+    const size_t kGroupsPerThread = 4; // spare groups even out uneven elements
+
+    ParallelParser::ParallelParser(InputSource &aSource, size_t aThreadCount)
+        : source(aSource), threadCount(aThreadCount ? aThreadCount : 1) {}
+
+    std::string_view ParallelParser::readDocument() {
+        std::string_view theDocument = source.nextBlock();
+        if (!source.isContiguous()) {
+            document.assign(theDocument);
+            for (auto theBlock = source.nextBlock(); !theBlock.empty(); theBlock = source.nextBlock())
+                document.append(theBlock);
+            theDocument = document;
+        }
+        return theDocument;
+    }
+
+    bool ParallelParser::parse(Model &aModel) {
+        const std::string_view theDocument = readDocument();
+        if (threadCount > 1 && theDocument.size() >= kMinParallelSize && parseParallel(theDocument, aModel))
+            return true;
+        return parseSequential(theDocument, aModel);
+    }
+
+    bool ParallelParser::parseSequential(std::string_view aDocument, Model &aModel) {
+        BufferSource theSource(aDocument);
+        return BasicJSONParser<Model>(theSource).parse(&aModel);
+    }
+
+    // Chunks are indexed twice over: first to learn which of them start inside a string,
+    // then for real, with that state carried in
+    bool ParallelParser::buildIndex(std::string_view aDocument, ThreadPool &aPool) {
+        const size_t theCount = std::max({size_t{1}, std::min(aDocument.size() / kMinChunkSize, threadCount * kChunksPerThread),
+                                          aDocument.size() / StructuralIndex::kMaxDocumentSize + 1});
+        chunks = std::vector<IndexedChunk>(theCount);
+        auto getPiece = [&](size_t anIndex) {
+            const size_t theEnd = anIndex + 1 < theCount ? aDocument.size() / theCount * (anIndex + 1) : aDocument.size();
+            return aDocument.substr(chunks[anIndex].base, theEnd - chunks[anIndex].base);
+        };
+        for (size_t i = 0; i < theCount; ++i)
+            chunks[i].base = aDocument.size() / theCount * i;
+
+        std::unique_ptr<bool[]> theFlips(new bool[theCount]);
+        aPool.parallelFor(theCount, [&](size_t anIndex) {
+            const auto theCarry = StructuralIndex::getCarry(aDocument, chunks[anIndex].base, false);
+            theFlips[anIndex] = StructuralIndex::flipsString(getPiece(anIndex), theCarry.isEscaping);
+        });
+
+        std::unique_ptr<bool[]> isInString(new bool[theCount]);
+        for (size_t i = 0; i < theCount; ++i)
+            isInString[i] = i > 0 && (isInString[i - 1] != theFlips[i - 1]);
+
+        std::unique_ptr<bool[]> isBuilt(new bool[theCount]);
+        aPool.parallelFor(theCount, [&](size_t anIndex) {
+            const auto theCarry = StructuralIndex::getCarry(aDocument, chunks[anIndex].base, isInString[anIndex]);
+            isBuilt[anIndex] = chunks[anIndex].index.build(getPiece(anIndex), theCarry);
+        });
+        return std::all_of(isBuilt.get(), isBuilt.get() + theCount, [](bool isDone) { return isDone; });
+    }
+
+    bool ParallelParser::advance(Entry &anEntry) const {
+        ++anEntry.index;
+        while (anEntry.chunk < chunks.size() && anEntry.index >= chunks[anEntry.chunk].index.size()) {
+            ++anEntry.chunk;
+            anEntry.index = 0;
+        }
+        return anEntry.chunk < chunks.size();
+    }
+
+    // Walks the index from a container's opening bracket to its closing one
+    bool ParallelParser::scanContainer(std::string_view aDocument, Entry anOpen, ContainerScan &aScan) const {
+        aScan.open = offsetOf(anOpen);
+        aScan.type = '{' == aDocument[aScan.open] ? Element::object : Element::array;
+
+        const bool isObject = Element::object == aScan.type;
+        std::vector<std::string_view> theKeys;
+        std::string_view theKey;
+        bool isExpectingKey = isObject;
+        size_t theElement = 0;
+        Entry theChild;
+        size_t theChildStart = 0;
+
+        size_t theDepth = 1;
+        size_t theQuote = 0; // offset of an opening quote whose closing one is the next entry
+        bool isInQuote = false;
+        for (size_t theChunk = anOpen.chunk; theChunk < chunks.size(); ++theChunk) {
+            const StructuralIndex &theIndex = chunks[theChunk].index;
+            const size_t theBase = chunks[theChunk].base;
+            for (size_t i = theChunk == anOpen.chunk ? anOpen.index + 1 : 0; i < theIndex.size(); ++i) {
+                const size_t theOffset = theBase + theIndex[i];
+                if (isInQuote) {
+                    if (1 == theDepth && isExpectingKey) {
+                        theKey = aDocument.substr(theQuote + 1, theOffset - theQuote - 1);
+                        theKeys.push_back(theKey);
+                        isExpectingKey = false;
+                    }
+                    isInQuote = false;
+                    continue;
+                }
+
+                switch (aDocument[theOffset]) {
+                    case '"':
+                        theQuote = theOffset;
+                        isInQuote = true;
+                        break;
+
+                    case '{':
+                    case '[':
+                        if (1 == theDepth) {
+                            theChild = {theChunk, i};
+                            theChildStart = theOffset;
+                        }
+                        ++theDepth;
+                        break;
+
+                    case '}':
+                    case ']':
+                        if (0 == --theDepth) {
+                            aScan.close = theOffset;
+                            if (isObject && aScan.childSpan)
+                                aScan.hasDuplicateKey = std::count(theKeys.begin(), theKeys.end(), aScan.childKey) > 1;
+                            return true;
+                        }
+                        if (1 == theDepth && theOffset - theChildStart + 1 > aScan.childSpan) {
+                            aScan.childSpan = theOffset - theChildStart + 1;
+                            aScan.childEntry = theChild;
+                            aScan.childIndex = theElement;
+                            aScan.childKey = theKey;
+                        }
+                        break;
+
+                    case ',':
+                        if (1 == theDepth) {
+                            aScan.separators.push_back(theOffset);
+                            ++theElement;
+                            isExpectingKey = isObject;
+                        }
+                        break;
+
+                    default:
+                        break;
+                }
+            }
+        }
+        return false; // Never closed
+    }
+
+    bool ParallelParser::parseParallel(std::string_view aDocument, Model &aModel) {
+        ThreadPool thePool(threadCount);
+        if (!buildIndex(aDocument, thePool))
+            return false;
+
+        Entry theRoot;
+        if (chunks[0].index.size() == 0 && !advance(theRoot))
+            return false;
+        const char theFirst = aDocument[offsetOf(theRoot)];
+        if ('{' != theFirst && '[' != theFirst)
+            return false;
+
+        // Go down while most of the document sits in one element
+        const size_t theGroupCount = threadCount * kGroupsPerThread;
+        std::vector<PathStep> thePath;
+        ContainerScan theScan;
+        if (!scanContainer(aDocument, theRoot, theScan))
+            return false;
+        while (theScan.separators.size() + 1 < theGroupCount && 2 * theScan.childSpan > theScan.close - theScan.open &&
+               !theScan.hasDuplicateKey) {
+            thePath.push_back({theScan.childIndex, theScan.childKey});
+            ContainerScan theChild;
+            if (!scanContainer(aDocument, theScan.childEntry, theChild))
+                return false;
+            theScan = std::move(theChild);
+        }
+        if (theScan.separators.empty())
+            return false; // Nothing worth splitting
+
+        // Cut the container at the commas nearest to even shares of its bytes
+        std::vector<std::string_view> theFragments;
+        size_t theStart = theScan.open + 1;
+        auto theSeparator = theScan.separators.begin();
+        const size_t theGroups = std::min(theGroupCount, theScan.separators.size() + 1);
+        for (size_t i = 1; i < theGroups && theSeparator != theScan.separators.end(); ++i) {
+            const size_t theTarget = theScan.open + (theScan.close - theScan.open) / theGroups * i;
+            theSeparator = std::lower_bound(theSeparator, theScan.separators.end(), std::max(theTarget, theStart));
+            if (theSeparator == theScan.separators.end())
+                break;
+            theFragments.push_back(aDocument.substr(theStart, *theSeparator - theStart));
+            theStart = *theSeparator++ + 1;
+        }
+        theFragments.push_back(aDocument.substr(theStart, theScan.close - theStart));
+
+        // Everything around the container, with the container left empty
+        Model theSkeleton(ModelMode::eager, aModel.getKeyOrder());
+        bool isSkeletonValid = false;
+        thePool.submit([&]() {
+            JSONPushParser theParser(&theSkeleton);
+            theParser.feed(aDocument.substr(0, theScan.open + 1));
+            theParser.feed(aDocument.substr(theScan.close));
+            isSkeletonValid = theParser.finish();
+        });
+
+        std::vector<Model> theParts(theFragments.size(), Model(ModelMode::eager, aModel.getKeyOrder()));
+        std::unique_ptr<bool[]> isPartValid(new bool[theFragments.size()]);
+        thePool.parallelFor(theFragments.size(), [&](size_t anIndex) {
+            BasicJSONParser<Model> theParser;
+            isPartValid[anIndex] = theParser.parseFragment(theFragments[anIndex], theScan.type, &theParts[anIndex]);
+        });
+        thePool.wait(); // for the skeleton, which parallelFor doesn't wait on
+
+        if (!isSkeletonValid || !std::all_of(isPartValid.get(), isPartValid.get() + theFragments.size(),
+                                             [](bool isValid) { return isValid; }))
+            return false;
+
+        ModelNode *theNode = &theSkeleton.getRoot();
+        for (const auto &theStep : thePath) {
+            if (ModelNode::Type::object == theNode->getType())
+                theNode = theNode->find(theStep.key);
+            else if (ModelNode::Type::list == theNode->getType())
+                theNode = theStep.index < theNode->size() ? &theNode->getItems()[theStep.index] : nullptr;
+            else
+                theNode = nullptr;
+            if (!theNode)
+                return false;
+        }
+
+        // Stitch the parts in order; an object keeps the first of any repeated key, as Model does
+        if (Element::array == theScan.type) {
+            if (ModelNode::Type::list != theNode->getType())
+                return false;
+            std::vector<ModelNode> theItems(theNode->getItems(), theNode->getItems() + theNode->size());
+            for (auto &thePart : theParts) {
+                const ModelNode &thePartRoot = thePart.getRoot();
+                theItems.insert(theItems.end(), thePartRoot.getItems(), thePartRoot.getItems() + thePartRoot.size());
+            }
+            if (theItems.size() > ModelNode::kMaxSize)
+                return false;
+            *theNode = ModelNode::makeList(theItems.data(), theItems.size(), aModel.getArena());
+        }
+        else {
+            if (ModelNode::Type::object != theNode->getType())
+                return false;
+            std::vector<ModelNode::Member> theMembers(theNode->getMembers(), theNode->getMembers() + theNode->size());
+            for (auto &thePart : theParts) {
+                const ModelNode &thePartRoot = thePart.getRoot();
+                theMembers.insert(theMembers.end(), thePartRoot.getMembers(), thePartRoot.getMembers() + thePartRoot.size());
+            }
+            if (theMembers.size() > ModelNode::kMaxSize)
+                return false;
+            *theNode = ModelNode::makeObject(theMembers.data(), theMembers.data() + theMembers.size(), aModel.getArena(),
+                                              aModel.getKeyOrder());
+        }
+
+        // Each part built its nodes in its own arena, on its own thread; the Model keeps them all
+        aModel.setRoot(theSkeleton.getRoot());
+        aModel.getArena().keep(theSkeleton.shareArena());
+        for (auto &thePart : theParts)
+            aModel.getArena().keep(thePart.shareArena());
+        return true;
+    }
+
+}
@@ -0,0 +1,80 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include "InputSource.h"
+#include "Model.h"
+#include "StructuralIndex.h"
+#include "ThreadPool.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace JSONProc {
+
+    // Builds a Model from one large document on several threads:
+    //  1. the document is indexed in chunks, each told whether it starts inside a string;
+    //  2. the index leads down to the container holding most of the document;
+    //  3. that container's elements are parsed in groups, each into its own subtree;
+    //  4. the subtrees are stitched, in order, into a Model of everything around the container.
+    // The Model is the same as JSONParser's. Small or invalid documents are parsed sequentially.
+    class ParallelParser {
+    public:
+        static constexpr size_t kMinParallelSize = 1024 * 1024;
+
+        ParallelParser(InputSource &aSource, size_t aThreadCount = ThreadPool::getDefaultThreadCount());
+
+        bool parse(Model &aModel);
+
+    protected:
+        // One chunk's index; its offsets are relative to base
+        struct IndexedChunk {
+            size_t base = 0;
+            StructuralIndex index;
+        };
+
+        // An index entry, as a chunk and a position in that chunk's index
+        struct Entry {
+            size_t chunk = 0;
+            size_t index = 0;
+        };
+
+        // The elements of one container, found by walking the index
+        struct ContainerScan {
+            Element type = Element::unknown;
+            size_t open = 0;
+            size_t close = 0;
+            std::vector<size_t> separators; // offsets of the container's own commas
+
+            // The largest element that is itself a container
+            Entry childEntry;
+            size_t childSpan = 0;
+            size_t childIndex = 0;       // position in a list...
+            std::string_view childKey;   // ...or key in an object
+            bool hasDuplicateKey = false;
+        };
+
+        // How to get from a container to one of its elements
+        struct PathStep {
+            size_t index;
+            std::string_view key;
+        };
+
+        std::string_view readDocument();
+        bool buildIndex(std::string_view aDocument, ThreadPool &aPool);
+        bool scanContainer(std::string_view aDocument, Entry anOpen, ContainerScan &aScan) const;
+        bool parseParallel(std::string_view aDocument, Model &aModel);
+        bool parseSequential(std::string_view aDocument, Model &aModel);
+
+        size_t offsetOf(Entry anEntry) const { return chunks[anEntry.chunk].base + chunks[anEntry.chunk].index[anEntry.index]; }
+        bool advance(Entry &anEntry) const;
+
+        InputSource &source;
+        size_t threadCount;
+        std::string document; // copy of a source that isn't contiguous
+        std::vector<IndexedChunk> chunks;
+    };
+
+}
@@ -0,0 +1,99 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "ParseTape.h"
+
+namespace JSONProc {
+
+    bool ParseTape::store(std::string_view aText, Text &aResult) {
+        if (aText.size() > kMaxSize - text.size())
+            return false;
+
+        aResult = {static_cast<Index>(text.size()), static_cast<Index>(aText.size())};
+        text.append(aText);
+        return true;
+    }
+
+    // Appends an entry for aKey, or returns nullptr when the tape is full
+    ParseTape::Entry* ParseTape::add(std::string_view aKey, Kind aKind) {
+        Entry theEntry{};
+        theEntry.kind = aKind;
+        if (entries.size() >= kMaxSize || !store(aKey, theEntry.key))
+            return nullptr;
+
+        entries.push_back(theEntry);
+        return &entries.back();
+    }
+
+    bool ParseTape::openContainer(std::string_view aKey, Element aType) {
+        if (!add(aKey, Element::array == aType ? Kind::array : Kind::object))
+            return false;
+
+        openings.push_back(static_cast<Index>(entries.size() - 1));
+        return true;
+    }
+
+    bool ParseTape::closeContainer() {
+        if (openings.empty())
+            return false;
+
+        entries[openings.back()].end = static_cast<Index>(entries.size());
+        openings.pop_back();
+        return true;
+    }
+
+    bool ParseTape::addString(std::string_view aKey, std::string_view aValue) {
+        Entry *theEntry = add(aKey, Kind::string);
+        return theEntry && store(aValue, theEntry->string);
+    }
+
+    // Constants that arrive as text, from listeners that don't convert them
+    bool ParseTape::addConstant(std::string_view aKey, std::string_view aText) {
+        const JSONConstant theConstant = JSONConstant::parse(aText);
+        switch (theConstant.kind) {
+            case JSONConstant::Kind::integer: return addInteger(aKey, theConstant.integer);
+            case JSONConstant::Kind::real:    return addReal(aKey, theConstant.real);
+            case JSONConstant::Kind::boolean: return addBool(aKey, theConstant.boolean);
+            default:                          return addNull(aKey);
+        }
+    }
+
+    bool ParseTape::addInteger(std::string_view aKey, std::int64_t aValue) {
+        Entry *theEntry = add(aKey, Kind::integer);
+        if (!theEntry)
+            return false;
+
+        theEntry->integer = aValue;
+        return true;
+    }
+
+    bool ParseTape::addReal(std::string_view aKey, double aValue) {
+        Entry *theEntry = add(aKey, Kind::real);
+        if (!theEntry)
+            return false;
+
+        theEntry->real = aValue;
+        return true;
+    }
+
+    bool ParseTape::addBool(std::string_view aKey, bool aValue) {
+        Entry *theEntry = add(aKey, Kind::boolean);
+        if (!theEntry)
+            return false;
+
+        theEntry->boolean = aValue;
+        return true;
+    }
+
+    bool ParseTape::addNull(std::string_view aKey) {
+        return add(aKey, Kind::null) != nullptr;
+    }
+
+    ParseTape::Index ParseTape::getNext(Index anIndex) const {
+        const Entry &theEntry = entries[anIndex];
+        const bool isContainer = Kind::object == theEntry.kind || Kind::array == theEntry.kind;
+        return isContainer ? theEntry.end : anIndex + 1;
+    }
+
+}
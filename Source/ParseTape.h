@@ -0,0 +1,72 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include "JSONListener.h"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace JSONProc {
+
+    // A compact record of one parse: a fixed-size entry per value in document order, with keys
+    // and strings packed into a single buffer. A container's entry knows where its subtree ends,
+    // so readers can step over it without looking inside. Lazy Models decode it one container
+    // at a time, when a query first visits that container.
+    class ParseTape {
+    public:
+        using Index = std::uint32_t;
+        static constexpr size_t kMaxSize = std::numeric_limits<Index>::max();
+
+        enum class Kind : std::uint8_t { object, array, string, integer, real, boolean, null };
+
+        // A run of the text buffer
+        struct Text {
+            Index offset;
+            Index length;
+        };
+
+        struct Entry {
+            Text key; // empty for list items and the root
+            Kind kind;
+            union {
+                Text string;
+                std::int64_t integer;
+                double real;
+                bool boolean;
+                Index end; // containers: one past the last entry of the subtree
+            };
+        };
+
+        // Recording; each returns false once the tape would outgrow kMaxSize
+        bool openContainer(std::string_view aKey, Element aType);
+        bool closeContainer();
+        bool addString(std::string_view aKey, std::string_view aValue);
+        bool addConstant(std::string_view aKey, std::string_view aText);
+        bool addInteger(std::string_view aKey, std::int64_t aValue);
+        bool addReal(std::string_view aKey, double aValue);
+        bool addBool(std::string_view aKey, bool aValue);
+        bool addNull(std::string_view aKey);
+
+        // Reading
+        size_t size() const { return entries.size(); }
+        const Entry& operator[](Index anIndex) const { return entries[anIndex]; }
+        std::string_view getText(Text aText) const { return {text.data() + aText.offset, aText.length}; }
+
+        // The entry after anIndex's subtree
+        Index getNext(Index anIndex) const;
+
+    protected:
+        Entry* add(std::string_view aKey, Kind aKind);
+        bool store(std::string_view aText, Text &aResult);
+
+        std::vector<Entry> entries;
+        std::string text;
+        std::vector<Index> openings; // containers that haven't closed yet
+    };
+
+}
@@ -0,0 +1,61 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "Projection.h"
+
+namespace JSONProc {
+
+    Projection::Projection(const std::vector<std::string> &aPaths) {
+        for (const auto &thePath : aPaths)
+            addPath(thePath);
+    }
+
+    void Projection::addPath(const std::string &aPath) {
+        const QueryPath thePath(aPath);
+        addSteps(thePath.getSteps().begin(), thePath.getSteps().end());
+    }
+
+    void Projection::addSteps(std::vector<QueryPath::Step>::const_iterator aStep, std::vector<QueryPath::Step>::const_iterator anEnd) {
+        Projection *theNode = this;
+        for (; aStep != anEnd; ++aStep) {
+            if (theNode->isComplete || QueryPath::Kind::child != aStep->kind)
+                break; // * and .. can reach anything below, so all of it is kept
+
+            auto theChild = theNode->children.find(aStep->key);
+            if (theChild == theNode->children.end())
+                theChild = theNode->children.emplace(aStep->key, Projection()).first;
+            if (QueryPath::kNoIndex != aStep->index) {
+                const auto theIndexed = theNode->indices.emplace(aStep->index, &theChild->second).first;
+                if (theIndexed->second != &theChild->second)
+                    theIndexed->second->addSteps(aStep + 1, anEnd); // the same index spelled another way
+            }
+            theNode = &theChild->second;
+        }
+
+        // Anything below a complete node is already kept
+        theNode->isComplete = true;
+        theNode->children.clear();
+        theNode->indices.clear();
+    }
+
+    const Projection* Projection::find(std::string_view aKey) const {
+        if (isComplete)
+            return this;
+        const auto theChild = children.find(aKey);
+        return theChild != children.end() ? &theChild->second : nullptr;
+    }
+
+    const Projection* Projection::find(size_t anIndex) const {
+        if (isComplete)
+            return this;
+        const auto theChild = indices.find(anIndex);
+        return theChild != indices.end() ? theChild->second : nullptr;
+    }
+
+    const Projection& Projection::getEverything() {
+        static const Projection theEverything({""});
+        return theEverything;
+    }
+
+}
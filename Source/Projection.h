@@ -0,0 +1,54 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include "QueryPath.h"
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace JSONProc {
+
+    // The parts of a document that a set of select paths reach, as a tree of path steps.
+    // A parser given a Projection builds only those parts: other object members are left
+    // out, and other list items become nulls so the selected items keep their indices.
+    class Projection {
+    public:
+        Projection() = default;
+        Projection(const std::vector<std::string> &aPaths);
+
+        // indices points into children, so a copy would point into the original
+        Projection(const Projection&) = delete;
+        Projection &operator=(const Projection&) = delete;
+        Projection(Projection&&) = default;
+        Projection &operator=(Projection&&) = default;
+
+        // Same 'a'.'b'.0 syntax as ModelQuery::select; an empty path selects everything, and
+        // a path keeps everything from its first * or .. step on
+        void addPath(const std::string &aPath);
+
+        // Step to an object member or list item; nullptr when no path goes there
+        const Projection* find(std::string_view aKey) const;
+        const Projection* find(size_t anIndex) const;
+
+        // A path ends here, so everything below is kept
+        bool isSelected() const { return isComplete; }
+
+        // Keeps everything
+        static const Projection& getEverything();
+
+    protected:
+        void addSteps(std::vector<QueryPath::Step>::const_iterator aStep, std::vector<QueryPath::Step>::const_iterator anEnd);
+
+        bool isComplete = false;
+        std::map<std::string, Projection, std::less<>> children;
+        // the children whose step is a list index; when two steps spell one index differently,
+        // as 1 and 01 do, the first one's child keeps both paths
+        std::map<size_t, Projection*> indices;
+    };
+
+}
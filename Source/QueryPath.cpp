@@ -0,0 +1,47 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "QueryPath.h"
+#include <charconv>
+
+namespace JSONProc {
+
+    QueryPath::QueryPath(std::string_view aPath) : text(aPath) {
+        while (!aPath.empty()) {
+            if (0 == aPath.rfind("..", 0)) {
+                steps.push_back({"", kNoIndex, false, Kind::descendants});
+                isSet = true;
+                aPath.remove_prefix(2);
+                continue;
+            }
+
+            const size_t theDot = std::min(aPath.find('.'), aPath.size());
+            addStep(aPath.substr(0, theDot));
+            aPath.remove_prefix(theDot);
+            if (aPath.rfind("..", 0) != 0) // a .. after the key is a step of its own
+                aPath.remove_prefix(std::min<size_t>(1, aPath.size()));
+        }
+    }
+
+    void QueryPath::addStep(std::string_view aKey) {
+        if ("*" == aKey) {
+            steps.push_back({"*", kNoIndex, false, Kind::wildcard});
+            isSet = true;
+            return;
+        }
+        if (aKey.size() >= 2 && '\'' == aKey.front() && '\'' == aKey.back())
+            aKey = aKey.substr(1, aKey.size() - 2);
+
+        // leading digits count, as they do for std::stoi
+        Step theStep{std::string(aKey)};
+        long theNumber = 0;
+        const auto theResult = std::from_chars(aKey.data(), aKey.data() + aKey.size(), theNumber);
+        if (std::errc() == theResult.ec) {
+            theStep.isNumber = true;
+            theStep.index = theNumber < 0 ? kNoIndex : static_cast<size_t>(theNumber);
+        }
+        steps.push_back(std::move(theStep));
+    }
+
+}
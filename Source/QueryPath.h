@@ -0,0 +1,47 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace JSONProc {
+
+    // A select path ('a'.'b'.0) decoded once into its steps, so it can be walked again and
+    // again, against any number of documents, without re-parsing the text.
+    // An unquoted * step takes every child and a .. step takes every node below (and including)
+    // the current ones, so 'students'.*.'grade' or ..'grade' select a set of nodes.
+    class QueryPath {
+    public:
+        static constexpr size_t kNoIndex = static_cast<size_t>(-1);
+
+        enum class Kind : std::uint8_t { child, wildcard, descendants };
+
+        struct Step {
+            std::string key;          // without its apostrophes
+            size_t index = kNoIndex;  // key read as a list index; kNoIndex when it isn't a number
+            bool isNumber = false;    // negative numbers are numbers, but never a valid index
+            Kind kind = Kind::child;
+        };
+
+        QueryPath() = default; // selects the root
+        QueryPath(std::string_view aPath);
+
+        const std::vector<Step>& getSteps() const { return steps; }
+        const std::string& getText() const { return text; }
+        bool empty() const { return steps.empty(); }
+        bool selectsSet() const { return isSet; } // has a * or .. step
+
+    protected:
+        void addStep(std::string_view aKey);
+
+        std::string text;
+        std::vector<Step> steps;
+        bool isSet = false;
+    };
+
+}
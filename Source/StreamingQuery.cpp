@@ -0,0 +1,200 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "StreamingQuery.h"
+#include "BasicJSONParser.h"
+#include "NumberKernels.h"
+#include <cmath>
+
+namespace JSONProc {
+
+    StreamingQuery::StreamingQuery(const QueryPath &aPath, Consumer aConsumer)
+        : steps(aPath.getSteps()), consumer(aConsumer) {
+        projection.addPath(aPath.getText());
+    }
+
+    bool StreamingQuery::run(InputSource &aSource) {
+        BasicJSONParser<StreamingQuery> theParser(aSource);
+        theParser.setProjection(&projection);
+        const bool isValid = theParser.parse(this);
+        bytesConsumed = theParser.getBytesConsumed();
+        return isValid;
+    }
+
+    double StreamingQuery::sum() const {
+        return std::round(reduceNumbers().value_or(0.0) * 100.0) / 100.0; //rounded, as ModelQuery::sum does
+    }
+
+    std::optional<double> StreamingQuery::avg() const {
+        const auto theSum = reduceNumbers();
+        if (!theSum)
+            return std::nullopt;
+        return std::round(*theSum / numberCount * 100.0) / 100.0;
+    }
+
+    //-----parser events-----
+
+    bool StreamingQuery::addKeyValuePair(std::string_view aKey, std::string_view aValue, Element aType, bool isEscaped) {
+        if (aValue.size() > ModelNode::kMaxSize)
+            return false; //too long for a node, as it is for Model
+        if (Stage::gathering == stage)
+            return gathered.addKeyValuePair(aKey, aValue, aType, isEscaped);
+        return addValue(aKey, std::nullopt, [&]() { return ModelNode::makeString(aValue, gathered.getArena()); });
+    }
+
+    bool StreamingQuery::addItem(std::string_view aValue, Element aType, bool isEscaped) {
+        if (aValue.size() > ModelNode::kMaxSize)
+            return false; //too long for a node, as it is for Model
+        if (Stage::gathering == stage)
+            return gathered.addItem(aValue, aType, isEscaped);
+        return addValue({}, std::nullopt, [&]() { return ModelNode::makeString(aValue, gathered.getArena()); });
+    }
+
+    bool StreamingQuery::addInteger(std::string_view aKey, std::int64_t aValue) {
+        if (Stage::gathering == stage)
+            return gathered.addInteger(aKey, aValue);
+        return addValue(aKey, static_cast<double>(aValue), [aValue]() { return ModelNode::makeInteger(static_cast<long>(aValue)); });
+    }
+
+    bool StreamingQuery::addDouble(std::string_view aKey, double aValue) {
+        if (Stage::gathering == stage)
+            return gathered.addDouble(aKey, aValue);
+        return addValue(aKey, aValue, [aValue]() { return ModelNode::makeNumber(aValue); });
+    }
+
+    bool StreamingQuery::addBool(std::string_view aKey, bool aValue) {
+        if (Stage::gathering == stage)
+            return gathered.addBool(aKey, aValue);
+        return addValue(aKey, std::nullopt, [aValue]() { return ModelNode::makeBool(aValue); });
+    }
+
+    bool StreamingQuery::addNull(std::string_view aKey) {
+        if (Stage::gathering == stage)
+            return gathered.addNull(aKey);
+        return addValue(aKey, std::nullopt, []() { return ModelNode(); });
+    }
+
+    bool StreamingQuery::openContainer(std::string_view aKey, Element aType) {
+        if (Stage::gathering == stage) {
+            ++depth;
+            return gathered.openContainer(aKey, aType);
+        }
+        if (Stage::finished == stage)
+            return false;
+        if (Stage::consuming == stage) {
+            if (depth == matched + 1)
+                addChild(aKey, std::nullopt);
+            ++depth;
+            return true;
+        }
+
+        //the root is where the path starts; below it, only the next step goes on
+        const bool isOnPath = 0 == depth || (depth == matched + 1 && takesStep(aKey));
+        if (depth++ > 0 && isOnPath)
+            ++matched;
+        if (!isOnPath)
+            return true;
+
+        isList = Element::array == aType;
+        index = 0;
+        if (matched < steps.size())
+            return !isList || steps[matched].isNumber || finish(); //a key never selects a list item
+
+        if (Consumer::get == consumer) {
+            stage = Stage::gathering;
+            return gathered.openContainer(aKey, aType);
+        }
+        stage = Stage::consuming;
+        return true;
+    }
+
+    bool StreamingQuery::closeContainer(std::string_view aKey, Element aType) {
+        if (Stage::finished == stage)
+            return false;
+        --depth;
+        if (Stage::gathering == stage) {
+            if (!gathered.closeContainer(aKey, aType))
+                return false;
+            if (depth == matched)
+                text = gathered.getRoot().toString();
+            return depth != matched || finish();
+        }
+
+        //the selected container is done, or the path's container ended without the next step
+        return depth != matched || finish();
+    }
+
+    //-----primitives-----
+
+    //a string or constant; aMakeNode makes its node, in case get() selected it
+    template <typename MakeNode>
+    bool StreamingQuery::addValue(std::string_view aKey, std::optional<double> aNumber, MakeNode aMakeNode) {
+        if (Stage::finished == stage)
+            return false;
+        if (depth != matched + 1)
+            return true; //below a container that isn't on the path
+        if (Stage::consuming == stage) {
+            addChild(aKey, aNumber);
+            return true;
+        }
+        if (!takesStep(aKey))
+            return true;
+
+        //a value has nothing to step into, so it's only selected by the path's last step
+        if (++matched == steps.size()) {
+            if (aNumber)
+                numbers.push_back(*aNumber);
+            if (Consumer::get == consumer)
+                text = aMakeNode().toString();
+        }
+        return finish();
+    }
+
+    bool StreamingQuery::takesStep(std::string_view aKey) {
+        const QueryPath::Step &theStep = steps[matched];
+        if (isList)
+            return index++ == theStep.index;
+        return aKey == theStep.key;
+    }
+
+    void StreamingQuery::addChild(std::string_view aKey, std::optional<double> aNumber) {
+        if (!isList && !keys.emplace(aKey).second)
+            return;
+        if (aNumber)
+            numbers.push_back(*aNumber);
+        if (0 == ++children % ModelQuery::kReductionBlock)
+            reduceBlock();
+    }
+
+    //the answer is final, so the parse stops here
+    bool StreamingQuery::finish() {
+        reduceBlock();
+        keys.clear();
+        stage = Stage::finished;
+        return false;
+    }
+
+    void StreamingQuery::reduceBlock() {
+        if (numbers.empty())
+            return;
+        blocks.push_back(reduce(numbers.data(), numbers.size()));
+        numberCount += numbers.size();
+        numbers.clear();
+    }
+
+    double StreamingQuery::reduce(const double *aValues, size_t aCount) const {
+        if (Consumer::min == consumer)
+            return NumberKernels::getMinimum(aValues, aCount);
+        if (Consumer::max == consumer)
+            return NumberKernels::getMaximum(aValues, aCount);
+        return NumberKernels::sum(aValues, aCount);
+    }
+
+    std::optional<double> StreamingQuery::reduceNumbers() const {
+        if (blocks.empty())
+            return std::nullopt;
+        return reduce(blocks.data(), blocks.size());
+    }
+
+}
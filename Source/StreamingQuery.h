@@ -0,0 +1,89 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include "InputSource.h"
+#include "JSONListener.h"
+#include "Model.h"
+#include "Projection.h"
+#include "QueryPath.h"
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace JSONProc {
+
+    // Answers one query straight from a parser's events, without building a Model. It only
+    // counts how deep the parse is and how many steps of the path it has matched, so its memory
+    // doesn't grow with the document; only get() of a container builds that container, and
+    // count() of an object remembers its keys. Once the answer is final the query is done, and
+    // stops the parse at the event that finished it.
+    // The answers are the ones ModelQuery gives for select(aPath) and then the consumer.
+    class StreamingQuery final : public JSONViewListener {
+    public:
+        enum class Consumer { count, sum, min, max, avg, get };
+
+        // aPath has no * or .. steps; get() reads the node it selects
+        StreamingQuery(const QueryPath &aPath, Consumer aConsumer);
+
+        // Parses aSource until the answer is final; false when the input turned out invalid first
+        bool run(InputSource &aSource);
+        size_t getBytesConsumed() const { return bytesConsumed; } // by the last run()
+
+        // The answer for the consumer the query was made with
+        size_t count() const { return children; }
+        double sum() const;
+        std::optional<double> min() const { return reduceNumbers(); }
+        std::optional<double> max() const { return reduceNumbers(); }
+        std::optional<double> avg() const;
+        std::optional<std::string> get() const { return text; }
+
+        bool addKeyValuePair(std::string_view aKey, std::string_view aValue, Element aType, bool isEscaped) override;
+        bool addItem(std::string_view aValue, Element aType, bool isEscaped) override;
+        bool openContainer(std::string_view aKey, Element aType) override;
+        bool closeContainer(std::string_view aKey, Element aType) override;
+        bool addInteger(std::string_view aKey, std::int64_t aValue) override;
+        bool addDouble(std::string_view aKey, double aValue) override;
+        bool addBool(std::string_view aKey, bool aValue) override;
+        bool addNull(std::string_view aKey) override;
+        bool isDone() const override { return Stage::finished == stage; }
+
+    protected:
+        // searching walks down the path, consuming reads the selected container's children,
+        // and gathering builds the container get() prints
+        enum class Stage { searching, consuming, gathering, finished };
+
+        template <typename MakeNode>
+        bool addValue(std::string_view aKey, std::optional<double> aNumber, MakeNode aMakeNode);
+        bool takesStep(std::string_view aKey);
+        void addChild(std::string_view aKey, std::optional<double> aNumber);
+        bool finish();
+        void reduceBlock();
+        double reduce(const double *aValues, size_t aCount) const;
+        std::optional<double> reduceNumbers() const;
+
+        std::vector<QueryPath::Step> steps;
+        Projection projection; // lets the parser step over everything off the path
+        Consumer consumer;
+        Stage stage = Stage::searching;
+
+        size_t depth = 0;     // containers open
+        size_t matched = 0;   // steps matched; the container they reach is open at depth matched + 1
+        size_t index = 0;     // children seen so far in that container
+        bool isList = false;  // that container is a list
+
+        size_t children = 0;             // of the selected container
+        std::set<std::string, std::less<>> keys; // an object's, since Model keeps the first of a repeated key
+        std::vector<double> numbers;     // the current block's, as ModelQuery reduces in blocks
+        std::vector<double> blocks;      // each block's reduction
+        size_t numberCount = 0;
+        std::optional<std::string> text; // what get() gives
+        Model gathered;
+        size_t bytesConsumed = 0;
+    };
+
+}
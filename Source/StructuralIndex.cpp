@@ -0,0 +1,311 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "StructuralIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    #define JSONPROC_X86_KERNELS 1
+    #include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+#endif
+
+namespace JSONProc {
+
+    const size_t kBlockSize = 64;
+
+    // Character classes of one block, one bit per byte
+    struct BlockMasks {
+        uint64_t quotes = 0;
+        uint64_t backslashes = 0;
+        uint64_t structurals = 0; // { } [ ] : ,
+        uint64_t whitespace = 0;  // the same set the parser skips
+    };
+
+    using Classifier = void (*)(const char *aBlock, BlockMasks &aMasks);
+
+    inline unsigned countTrailingZeros(uint64_t aBits) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long theIndex;
+        _BitScanForward64(&theIndex, aBits);
+        return static_cast<unsigned>(theIndex);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(aBits));
+#endif
+    }
+
+    // Bit i becomes the xor of bits 0..i, which turns quote positions into string ranges
+    inline uint64_t prefixXor(uint64_t aBits) {
+        aBits ^= aBits << 1;
+        aBits ^= aBits << 2;
+        aBits ^= aBits << 4;
+        aBits ^= aBits << 8;
+        aBits ^= aBits << 16;
+        aBits ^= aBits << 32;
+        return aBits;
+    }
+
+    // Characters that follow an odd run of backslashes. isEscaping carries an odd run
+    // that ends the block over to the next one.
+    uint64_t findEscaped(uint64_t aBackslashes, bool &isEscaping) {
+        uint64_t theEscaped = 0;
+        if (isEscaping) {
+            theEscaped = 1;
+            aBackslashes &= ~uint64_t{1};
+            isEscaping = false;
+        }
+
+        while (aBackslashes) {
+            const unsigned theStart = countTrailingZeros(aBackslashes);
+            const uint64_t theRest = ~(aBackslashes >> theStart);
+            const unsigned theEnd = theStart + (theRest ? countTrailingZeros(theRest) : 64);
+            if ((theEnd - theStart) % 2) {
+                if (theEnd < kBlockSize)
+                    theEscaped |= uint64_t{1} << theEnd;
+                else
+                    isEscaping = true;
+            }
+            aBackslashes = theEnd < kBlockSize ? aBackslashes & (~uint64_t{0} << theEnd) : 0;
+        }
+        return theEscaped;
+    }
+
+
+    // ---Scalar kernel---
+
+    enum CharFlags : uint8_t {
+        kQuoteFlag = 1, kBackslashFlag = 2, kStructuralFlag = 4, kWhitespaceFlag = 8
+    };
+
+    struct CharFlagTable {
+        constexpr CharFlagTable() : flags{} {
+            flags[static_cast<unsigned char>('"')] = kQuoteFlag;
+            flags[static_cast<unsigned char>('\\')] = kBackslashFlag;
+            for (const char theChar : {'{', '}', '[', ']', ':', ','})
+                flags[static_cast<unsigned char>(theChar)] = kStructuralFlag;
+            for (const char theChar : {' ', '\t', '\r', '\n', '\b', '\xff', '\0'})
+                flags[static_cast<unsigned char>(theChar)] = kWhitespaceFlag;
+        }
+
+        uint8_t flags[256];
+    };
+
+    constexpr CharFlagTable kCharFlags;
+
+    void classifyScalar(const char *aBlock, BlockMasks &aMasks) {
+        for (unsigned i = 0; i < kBlockSize; ++i) {
+            const uint64_t theFlags = kCharFlags.flags[static_cast<unsigned char>(aBlock[i])];
+            aMasks.quotes |= (theFlags & kQuoteFlag) << i;
+            aMasks.backslashes |= ((theFlags & kBackslashFlag) >> 1) << i;
+            aMasks.structurals |= ((theFlags & kStructuralFlag) >> 2) << i;
+            aMasks.whitespace |= ((theFlags & kWhitespaceFlag) >> 3) << i;
+        }
+    }
+
+
+#ifdef JSONPROC_X86_KERNELS
+
+    // ---SSE2 kernel (four 16 byte lanes)---
+
+    __attribute__((target("sse2")))
+    inline __m128i matchAny(__m128i aChars, std::initializer_list<char> aSet) {
+        __m128i theMatches = _mm_setzero_si128();
+        for (const char theChar : aSet)
+            theMatches = _mm_or_si128(theMatches, _mm_cmpeq_epi8(aChars, _mm_set1_epi8(theChar)));
+        return theMatches;
+    }
+
+    __attribute__((target("sse2")))
+    inline uint64_t toBits(__m128i aMatches, unsigned aLane) {
+        return static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(aMatches))) << (16 * aLane);
+    }
+
+    __attribute__((target("sse2")))
+    void classifySSE2(const char *aBlock, BlockMasks &aMasks) {
+        for (unsigned theLane = 0; theLane < 4; ++theLane) {
+            const __m128i theChars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aBlock + 16 * theLane));
+            const __m128i theFolded = _mm_or_si128(theChars, _mm_set1_epi8(0x20)); // '[' -> '{', ']' -> '}'
+
+            aMasks.quotes |= toBits(matchAny(theChars, {'"'}), theLane);
+            aMasks.backslashes |= toBits(matchAny(theChars, {'\\'}), theLane);
+            aMasks.structurals |= toBits(_mm_or_si128(matchAny(theFolded, {'{', '}'}),
+                                                      matchAny(theChars, {':', ','})), theLane);
+            aMasks.whitespace |= toBits(matchAny(theChars, {' ', '\t', '\r', '\n', '\b', '\xff', '\0'}), theLane);
+        }
+    }
+
+
+    // ---AVX2 kernel (two 32 byte lanes)---
+
+    __attribute__((target("avx2")))
+    inline __m256i matchAny(__m256i aChars, std::initializer_list<char> aSet) {
+        __m256i theMatches = _mm256_setzero_si256();
+        for (const char theChar : aSet)
+            theMatches = _mm256_or_si256(theMatches, _mm256_cmpeq_epi8(aChars, _mm256_set1_epi8(theChar)));
+        return theMatches;
+    }
+
+    __attribute__((target("avx2")))
+    inline uint64_t toBits(__m256i aMatches, unsigned aLane) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(aMatches))) << (32 * aLane);
+    }
+
+    __attribute__((target("avx2")))
+    void classifyAVX2(const char *aBlock, BlockMasks &aMasks) {
+        for (unsigned theLane = 0; theLane < 2; ++theLane) {
+            const __m256i theChars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(aBlock + 32 * theLane));
+            const __m256i theFolded = _mm256_or_si256(theChars, _mm256_set1_epi8(0x20));
+
+            aMasks.quotes |= toBits(matchAny(theChars, {'"'}), theLane);
+            aMasks.backslashes |= toBits(matchAny(theChars, {'\\'}), theLane);
+            aMasks.structurals |= toBits(_mm256_or_si256(matchAny(theFolded, {'{', '}'}),
+                                                         matchAny(theChars, {':', ','})), theLane);
+            aMasks.whitespace |= toBits(matchAny(theChars, {' ', '\t', '\r', '\n', '\b', '\xff', '\0'}), theLane);
+        }
+    }
+
+#endif
+
+    Classifier getClassifier(StructuralIndex::Kernel aKernel) {
+#ifdef JSONPROC_X86_KERNELS
+        if (StructuralIndex::isSupported(aKernel)) {
+            if (StructuralIndex::Kernel::avx2 == aKernel)
+                return classifyAVX2;
+            if (StructuralIndex::Kernel::sse2 == aKernel)
+                return classifySSE2;
+        }
+#endif
+        return classifyScalar;
+    }
+
+
+    // ---StructuralIndex---
+
+    bool StructuralIndex::isSupported(Kernel aKernel) {
+        switch (aKernel) {
+#ifdef JSONPROC_X86_KERNELS
+            case Kernel::avx2:
+                return __builtin_cpu_supports("avx2");
+            case Kernel::sse2:
+                return __builtin_cpu_supports("sse2");
+#endif
+            case Kernel::scalar:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    StructuralIndex::Kernel StructuralIndex::getBestKernel() {
+        static const Kernel theBest = isSupported(Kernel::avx2) ? Kernel::avx2
+                                    : isSupported(Kernel::sse2) ? Kernel::sse2 : Kernel::scalar;
+        return theBest;
+    }
+
+    const char* StructuralIndex::getName(Kernel aKernel) {
+        switch (aKernel) {
+            case Kernel::avx2: return "avx2";
+            case Kernel::sse2: return "sse2";
+            default: return "scalar";
+        }
+    }
+
+    void StructuralIndex::reserve(size_t aCapacity) {
+        if (aCapacity <= capacity)
+            return;
+
+        std::unique_ptr<Offset[]> theOffsets(new Offset[aCapacity]);
+        std::copy(begin(), end(), theOffsets.get());
+        offsets = std::move(theOffsets);
+        capacity = aCapacity;
+    }
+
+    // Classifies aText a block at a time and hands each block's masks, with escaped
+    // quotes removed, to aVisit
+    template <typename Visitor>
+    void scanBlocks(std::string_view aText, Classifier aClassify, bool isEscaping, Visitor aVisit) {
+        for (size_t theBase = 0; theBase < aText.size(); theBase += kBlockSize) {
+            const char *theBlock = aText.data() + theBase;
+            char thePadded[kBlockSize];
+            if (aText.size() - theBase < kBlockSize) {
+                std::memset(thePadded, ' ', kBlockSize);
+                std::memcpy(thePadded, theBlock, aText.size() - theBase);
+                theBlock = thePadded;
+            }
+
+            BlockMasks theMasks;
+            aClassify(theBlock, theMasks);
+            const uint64_t theQuotes = theMasks.quotes & ~findEscaped(theMasks.backslashes, isEscaping);
+            aVisit(theBase, theMasks, theQuotes);
+        }
+    }
+
+    StructuralIndex::Carry StructuralIndex::getCarry(std::string_view aDocument, size_t anOffset, bool isInString) {
+        Carry theCarry;
+        theCarry.isInString = isInString;
+
+        size_t theBackslashes = 0;
+        while (theBackslashes < anOffset && '\\' == aDocument[anOffset - theBackslashes - 1])
+            ++theBackslashes;
+        theCarry.isEscaping = theBackslashes % 2;
+
+        const uint8_t kBreaksConstant = kQuoteFlag | kStructuralFlag | kWhitespaceFlag;
+        theCarry.wasConstant = !isInString && anOffset > 0 &&
+            !(kCharFlags.flags[static_cast<unsigned char>(aDocument[anOffset - 1])] & kBreaksConstant);
+        return theCarry;
+    }
+
+    bool StructuralIndex::flipsString(std::string_view aPiece, bool isEscaping, Kernel aKernel) {
+        uint64_t theParity = 0;
+        scanBlocks(aPiece, getClassifier(aKernel), isEscaping, [&](size_t, const BlockMasks&, uint64_t theQuotes) {
+            theParity ^= prefixXor(theQuotes) >> 63;
+        });
+        return theParity;
+    }
+
+    bool StructuralIndex::build(std::string_view aDocument, Kernel aKernel) {
+        return build(aDocument, Carry(), aKernel);
+    }
+
+    bool StructuralIndex::build(std::string_view aPiece, const Carry &aCarry, Kernel aKernel) {
+        count = 0;
+        if (aPiece.size() > kMaxDocumentSize)
+            return false;
+
+        reserve(aPiece.size() / 4 + kBlockSize);
+
+        uint64_t isInString = aCarry.isInString ? ~uint64_t{0} : 0; // all ones while a string continues into the next block
+        uint64_t wasConstant = aCarry.wasConstant;                    // 1 when the previous block ended inside a constant
+
+        scanBlocks(aPiece, getClassifier(aKernel), aCarry.isEscaping,
+                   [&](size_t theBase, const BlockMasks &theMasks, uint64_t theQuotes) {
+            const uint64_t theStrings = prefixXor(theQuotes) ^ isInString;
+            isInString = 0 - (theStrings >> 63);
+
+            const uint64_t theConstants = ~(theMasks.quotes | theMasks.structurals | theMasks.whitespace) & ~theStrings;
+            const uint64_t theConstantStarts = theConstants & ~((theConstants << 1) | wasConstant);
+            wasConstant = theConstants >> 63;
+
+            uint64_t theBits = (theMasks.structurals & ~theStrings) | theQuotes | theConstantStarts;
+
+            if (capacity < count + kBlockSize)
+                reserve(2 * capacity);
+            Offset *theOutput = offsets.get() + count;
+            const Offset theOffset = static_cast<Offset>(theBase);
+            while (theBits) {
+                *theOutput++ = theOffset + countTrailingZeros(theBits);
+                theBits &= theBits - 1;
+            }
+            count = static_cast<size_t>(theOutput - offsets.get());
+        });
+
+        return true;
+    }
+
+}
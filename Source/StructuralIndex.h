@@ -0,0 +1,62 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string_view>
+
+namespace JSONProc {
+
+    // Offsets of every quote, brace, bracket, colon and comma outside of strings, plus the
+    // first character of every constant. Built 64 bytes at a time with the widest vector
+    // unit the CPU supports; the parser then walks these offsets instead of the characters.
+    class StructuralIndex {
+    public:
+        using Offset = std::uint32_t;
+        static constexpr size_t kMaxDocumentSize = std::numeric_limits<Offset>::max();
+
+        enum class Kernel { scalar, sse2, avx2 };
+
+        static Kernel getBestKernel();
+        static bool isSupported(Kernel aKernel);
+        static const char* getName(Kernel aKernel);
+
+        // What the scan must know about the text before a piece of a larger document
+        struct Carry {
+            bool isEscaping = false;  // an odd run of backslashes ends right before the piece
+            bool isInString = false;
+            bool wasConstant = false; // the piece starts in the middle of a constant
+        };
+
+        // Carry for the piece of aDocument that starts at anOffset
+        static Carry getCarry(std::string_view aDocument, size_t anOffset, bool isInString);
+
+        // True when aPiece holds an odd number of unescaped quotes, so it ends on the
+        // other side of a string boundary than it started
+        static bool flipsString(std::string_view aPiece, bool isEscaping, Kernel aKernel = getBestKernel());
+
+        // Documents larger than kMaxDocumentSize can't be indexed
+        bool build(std::string_view aDocument, Kernel aKernel = getBestKernel());
+
+        // Indexes one piece of a larger document; offsets are relative to the piece
+        bool build(std::string_view aPiece, const Carry &aCarry, Kernel aKernel = getBestKernel());
+
+        size_t size() const { return count; }
+        size_t operator[](size_t anIndex) const { return offsets[anIndex]; }
+
+        const Offset* begin() const { return offsets.get(); }
+        const Offset* end() const { return offsets.get() + count; }
+
+    protected:
+        void reserve(size_t aCapacity);
+
+        std::unique_ptr<Offset[]> offsets; // left uninitialized; only [0, count) is written
+        size_t count = 0;
+        size_t capacity = 0;
+    };
+
+}
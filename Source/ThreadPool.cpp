@@ -0,0 +1,85 @@
+//
+// Created on 10/17/2026.
+//
+
+#include "ThreadPool.h"
+
+namespace JSONProc {
+
+    size_t ThreadPool::getDefaultThreadCount() {
+        const unsigned theCount = std::thread::hardware_concurrency();
+        return theCount ? theCount : 1;
+    }
+
+    ThreadPool& ThreadPool::getShared() {
+        static ThreadPool thePool;
+        return thePool;
+    }
+
+    ThreadPool::ThreadPool(size_t aThreadCount) {
+        const size_t theCount = aThreadCount ? aThreadCount : 1;
+        workers.reserve(theCount);
+        for (size_t i = 0; i < theCount; ++i)
+            workers.emplace_back([this]() { run(); });
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> theLock(mutex);
+            isStopping = true;
+        }
+        hasWork.notify_all();
+        for (auto &theWorker : workers)
+            theWorker.join();
+    }
+
+    void ThreadPool::submit(std::function<void()> aTask) {
+        {
+            std::lock_guard<std::mutex> theLock(mutex);
+            tasks.push(std::move(aTask));
+        }
+        hasWork.notify_one();
+    }
+
+    void ThreadPool::wait() {
+        std::unique_lock<std::mutex> theLock(mutex);
+        isIdle.wait(theLock, [this]() { return tasks.empty() && 0 == active; });
+    }
+
+    void ThreadPool::parallelFor(size_t aCount, const std::function<void(size_t)>& aTask) {
+        size_t theRemaining = aCount;
+        std::condition_variable isDone;
+        for (size_t i = 0; i < aCount; ++i)
+            submit([&, i]() {
+                aTask(i);
+                std::lock_guard<std::mutex> theLock(mutex);
+                if (0 == --theRemaining)
+                    isDone.notify_all();
+            });
+
+        std::unique_lock<std::mutex> theLock(mutex);
+        isDone.wait(theLock, [&theRemaining]() { return 0 == theRemaining; });
+    }
+
+    void ThreadPool::run() {
+        for (;;) {
+            std::function<void()> theTask;
+            {
+                std::unique_lock<std::mutex> theLock(mutex);
+                hasWork.wait(theLock, [this]() { return isStopping || !tasks.empty(); });
+                if (tasks.empty())
+                    return; // Stopping, and nothing left to do
+                theTask = std::move(tasks.front());
+                tasks.pop();
+                ++active;
+            }
+
+            theTask();
+
+            std::lock_guard<std::mutex> theLock(mutex);
+            if (0 == --active && tasks.empty())
+                isIdle.notify_all();
+        }
+    }
+
+}
@@ -0,0 +1,56 @@
+//
+// Created on 10/17/2026.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace JSONProc {
+
+    // A fixed set of worker threads that run submitted tasks in FIFO order.
+    // Tasks must not throw.
+    class ThreadPool {
+    public:
+        static size_t getDefaultThreadCount();
+
+        // One pool for the whole process, made on first use, for short parallel steps such as a
+        // query's reductions. Tasks run on it must not wait on it themselves.
+        static ThreadPool& getShared();
+
+        explicit ThreadPool(size_t aThreadCount = getDefaultThreadCount());
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool &operator=(const ThreadPool&) = delete;
+
+        size_t size() const { return workers.size(); }
+
+        void submit(std::function<void()> aTask);
+
+        // Blocks until every submitted task has finished
+        void wait();
+
+        // Runs aTask(0) ... aTask(aCount - 1) on the pool and waits for all of them, but not for
+        // tasks other callers submitted
+        void parallelFor(size_t aCount, const std::function<void(size_t)>& aTask);
+
+    protected:
+        void run();
+
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable hasWork;
+        std::condition_variable isIdle;
+        size_t active = 0;
+        bool isStopping = false;
+    };
+
+}
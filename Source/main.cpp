@@ -4,6 +4,7 @@
 #include <map>
 #include "JSONParser.h"
 #include "Autograder.h"
+#include "Benchmark.h"
 #include "Testable.h"
 #include "Debug.h"
 
@@ -37,8 +38,21 @@ int runTest(const int argc, const char* argv[]) {
             {"compile",  [](const std::string &) { return true; }},
             {"nofilter", runNoFilterTest},
             {"query",    JSONProc::runModelQueryTest},
+            {"sources",  JSONProc::runInputSourceTest},
+            {"indexed",  JSONProc::runIndexedParseTest},
+            {"views",    JSONProc::runViewListenerTest},
+            {"push",     JSONProc::runPushParserTest},
+            {"lines",    JSONProc::runJSONLinesTest},
+            {"parallel", JSONProc::runParallelParseTest},
+            {"project",  JSONProc::runProjectionTest},
+            {"lazy",     JSONProc::runLazyModelTest},
+            {"arena",    JSONProc::runArenaTest},
+            {"order",    JSONProc::runKeyOrderTest},
+            {"cache",    JSONProc::runQueryCacheTest},
+            {"stream",   JSONProc::runStreamingQueryTest},
             {"basic",    runBasicTest},
-            {"advanced", runAdvancedTest}
+            {"advanced", runAdvancedTest},
+            {"bench",    JSONProc::runParserBenchmark}
     };
 
     if (theTestFunctions.count(theTest) == 0) {